@@ -6,13 +6,20 @@
 
 #include "coronatest.h"
 
+#include <QAbstractItemModel>
 #include <QAction>
 #include <QApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QProcess>
 #include <QRandomGenerator>
 #include <QSignalSpy>
 #include <QStandardPaths>
 
+#include <KConfig>
+#include <KConfigGroup>
+
 SimpleCorona::SimpleCorona(QObject *parent)
     : Plasma::Corona(parent)
 {
@@ -36,6 +43,21 @@ int SimpleCorona::screenForContainment(const Plasma::Containment *c) const
     return 0;
 }
 
+bool SimpleCorona::isContainmentOffScreen(const Plasma::Containment *c) const
+{
+    return screenForContainment(c) < 0;
+}
+
+ScreenlessCorona::ScreenlessCorona(QObject *parent)
+    : Plasma::Corona(parent)
+{
+}
+
+QRect ScreenlessCorona::screenGeometry(int screen) const
+{
+    return QRect(100 * screen, 100, 100, 100);
+}
+
 SimpleApplet::SimpleApplet(QObject *parentObject, const KPluginMetaData &data, const QVariantList &args)
     : Plasma::Applet(parentObject, data, args)
 {
@@ -77,6 +99,7 @@ void CoronaTest::initTestCase()
     QVERIFY(m_configDir.mkpath(QStringLiteral(".")));
 
     QVERIFY(QFile::copy(QStringLiteral(":/plasma-test-appletsrc"), m_configDir.filePath(QStringLiteral("plasma-test-appletsrc"))));
+    QVERIFY(QFile::copy(QStringLiteral(":/plasma-test-appletsrc"), m_configDir.filePath(QStringLiteral("plasma-test-async-appletsrc"))));
 }
 
 void CoronaTest::cleanupTestCase()
@@ -145,6 +168,534 @@ void CoronaTest::addRemoveApplets()
     QCOMPARE(m_corona->containments().at(0)->applets().count(), 2);
 }
 
+void CoronaTest::addAppletsBatch()
+{
+    Plasma::Containment *containment = m_corona->containments().at(0);
+    const int count = containment->applets().count();
+    QSignalSpy changedSpy(containment, &Plasma::Containment::appletsChanged);
+    QSignalSpy insertedSpy(containment, &Plasma::Containment::appletsInserted);
+    QSignalSpy removedSpy(containment, &Plasma::Containment::appletsRemoved);
+
+    QList<Plasma::Applet *> applets;
+    for (uint id : {1002, 1001, 1003}) {
+        applets << new Plasma::Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), id});
+    }
+    containment->addApplets(applets);
+
+    QCOMPARE(containment->applets().count(), count + 3);
+    QCOMPARE(containment->applets().at(count)->id(), uint(1001));
+    QCOMPARE(containment->applets().at(count + 2)->id(), uint(1003));
+    QCOMPARE(changedSpy.count(), 1);
+    // higher ids than anything there: they make a single run at the end
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(insertedSpy.at(0).at(0).toInt(), count);
+    QCOMPARE(insertedSpy.at(0).at(1).toInt(), count + 2);
+
+    containment->removeApplets(applets);
+    QCOMPARE(containment->applets().count(), count);
+    QCOMPARE(removedSpy.count(), 3);
+    // all the removals get notified together, right away
+    QCOMPARE(changedSpy.count(), 2);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    QCOMPARE(changedSpy.count(), 2);
+
+    // deleting a single applet notifies right away as well
+    Plasma::Applet *applet = new Plasma::Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), 1004});
+    containment->addApplet(applet);
+    QCOMPARE(changedSpy.count(), 3);
+    delete applet;
+    QCOMPARE(containment->applets().count(), count);
+    QCOMPARE(changedSpy.count(), 4);
+
+    // the positions of a batch which isn't contiguous work for a model following them one by one
+    applets.clear();
+    for (uint id : {1011, 1012, 1013, 1014}) {
+        applets << new Plasma::Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), id});
+    }
+    containment->addApplets(applets);
+    QList<Plasma::Applet *> model = containment->applets();
+    removedSpy.clear();
+    containment->removeApplets({applets.at(0), applets.at(2)});
+    QCOMPARE(removedSpy.count(), 2);
+    for (const QList<QVariant> &removal : std::as_const(removedSpy)) {
+        QCOMPARE(removal.at(0).toInt(), removal.at(1).toInt());
+        model.removeAt(removal.at(0).toInt());
+    }
+    QCOMPARE(model, containment->applets());
+    QVERIFY(model.contains(applets.at(1)));
+    QVERIFY(model.contains(applets.at(3)));
+    containment->removeApplets({applets.at(1), applets.at(3)});
+    QCOMPARE(containment->applets().count(), count);
+}
+
+void CoronaTest::appletsStatus()
+{
+    Plasma::Containment *containment = m_corona->containments().at(0);
+    const Plasma::Types::ItemStatus oldStatus = containment->status();
+    const auto oldApplets = containment->applets();
+    QList<Plasma::Types::ItemStatus> oldAppletStatuses;
+    for (auto applet : oldApplets) {
+        oldAppletStatuses << applet->status();
+        applet->setStatus(Plasma::Types::PassiveStatus);
+    }
+    containment->setStatus(Plasma::Types::PassiveStatus);
+
+    auto first = new Plasma::Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), 1010u});
+    auto second = new Plasma::Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), 1011u});
+    containment->addApplets({first, second});
+
+    // the containment follows the highest status of its applets
+    first->setStatus(Plasma::Types::NeedsAttentionStatus);
+    QCOMPARE(containment->status(), Plasma::Types::NeedsAttentionStatus);
+    second->setStatus(Plasma::Types::ActiveStatus);
+    QCOMPARE(containment->status(), Plasma::Types::NeedsAttentionStatus);
+    first->setStatus(Plasma::Types::PassiveStatus);
+    QCOMPARE(containment->status(), Plasma::Types::ActiveStatus);
+
+    // hidden counts as the lowest
+    second->setStatus(Plasma::Types::HiddenStatus);
+    QCOMPARE(containment->status(), Plasma::Types::ActiveStatus);
+    first->setStatus(Plasma::Types::ActiveStatus);
+    second->setStatus(Plasma::Types::RequiresAttentionStatus);
+    QCOMPARE(containment->status(), Plasma::Types::RequiresAttentionStatus);
+
+    // removed applets don't count anymore
+    delete second;
+    first->setStatus(Plasma::Types::PassiveStatus);
+    QCOMPARE(containment->status(), Plasma::Types::PassiveStatus);
+
+    delete first;
+    // the other tests share the corona, leave it as it was
+    for (int i = 0; i < oldApplets.count(); ++i) {
+        oldApplets.at(i)->setStatus(oldAppletStatuses.at(i));
+    }
+    containment->setStatus(oldStatus);
+    QCOMPARE(containment->status(), oldStatus);
+}
+
+void CoronaTest::constraintsFlush()
+{
+    Plasma::Containment *containment = m_corona->containments().at(0);
+    const auto applets = containment->applets();
+    QVERIFY(!applets.isEmpty());
+    const Plasma::Corona::ConstraintsStatistics before = m_corona->constraintsStatistics();
+
+    for (auto applet : applets) {
+        applet->updateConstraints(Plasma::Applet::LocationConstraint);
+    }
+    // the containment passes the form factor on to its applets, which are waiting already
+    containment->updateConstraints(Plasma::Applet::FormFactorConstraint);
+
+    QTRY_VERIFY(m_corona->constraintsStatistics().passes > before.passes);
+    const Plasma::Corona::ConstraintsStatistics after = m_corona->constraintsStatistics();
+    QCOMPARE(after.passes, before.passes + 1);
+    QCOMPARE(after.flushes, before.flushes + applets.count() + 1);
+    QCOMPARE(after.coalesced, before.coalesced + applets.count());
+
+    // what got flushed before the pass came isn't counted again
+    applets.first()->updateConstraints(Plasma::Applet::LocationConstraint);
+    applets.first()->flushPendingConstraintsEvents();
+    QTest::qWait(50);
+    QCOMPARE(m_corona->constraintsStatistics().flushes, after.flushes);
+    QCOMPARE(m_corona->constraintsStatistics().passes, after.passes);
+}
+
+void CoronaTest::containmentLookups()
+{
+    Plasma::Containment *panel = m_corona->containments().at(1);
+    QCOMPARE(panel->location(), Plasma::Types::BottomEdge);
+    QCOMPARE(m_corona->freeEdges(0),
+             QList<Plasma::Types::Location>({Plasma::Types::TopEdge, Plasma::Types::LeftEdge, Plasma::Types::RightEdge}));
+
+    // the indexes follow the containments moving around
+    panel->setLocation(Plasma::Types::TopEdge);
+    QCOMPARE(m_corona->freeEdges(0),
+             QList<Plasma::Types::Location>({Plasma::Types::BottomEdge, Plasma::Types::LeftEdge, Plasma::Types::RightEdge}));
+    panel->setLocation(Plasma::Types::BottomEdge);
+
+    QCOMPARE(m_corona->freeEdges(1).count(), 4);
+    QVERIFY(m_corona->containmentsForScreen(1).isEmpty());
+    QVERIFY(m_corona->containmentsForActivity(QStringLiteral("no-such-activity")).isEmpty());
+}
+
+void CoronaTest::asynchronousRestore()
+{
+    SimpleCorona corona;
+    corona.setAsynchronousLoadingEnabled(true);
+    QSignalSpy spy(&corona, SIGNAL(startupCompleted()));
+
+    corona.loadLayout(QStringLiteral("plasma-test-async-appletsrc"));
+    // nothing is there until the event loop runs
+    QVERIFY(corona.containments().isEmpty());
+
+    QTRY_COMPARE(corona.containments().count(), 3);
+    QCOMPARE(corona.containments().at(0)->id(), (uint)1);
+    QCOMPARE(corona.containments().at(1)->id(), (uint)4);
+    QCOMPARE(corona.containments().at(2)->id(), (uint)5);
+
+    // applets keep the order of a synchronous restore
+    QTRY_COMPARE(corona.containments().at(0)->applets().count(), 2);
+    QCOMPARE(corona.containments().at(0)->applets().at(0)->id(), (uint)2);
+    QCOMPARE(corona.containments().at(0)->applets().at(1)->id(), (uint)3);
+
+    QVERIFY(spy.count() || spy.wait(1000));
+    QVERIFY(corona.isStartupCompleted());
+
+    // asking for the containment of a screen while they are loading gives back the restored one
+    SimpleCorona pendingCorona;
+    pendingCorona.setAsynchronousLoadingEnabled(true);
+    pendingCorona.loadLayout(QStringLiteral("plasma-test-async-appletsrc"));
+    QVERIFY(pendingCorona.containments().isEmpty());
+    Plasma::Containment *containment = pendingCorona.containmentForScreen(0, QString(), QStringLiteral("simplecontainment"));
+    QVERIFY(containment);
+    QVERIFY(containment->id() <= 5);
+    QCOMPARE(pendingCorona.containments().count(), 3);
+    QTest::qWait(100);
+    QCOMPARE(pendingCorona.containments().count(), 3);
+}
+
+void CoronaTest::asynchronousConfigSync()
+{
+    m_corona->setAsynchronousConfigSyncEnabled(true);
+    QSignalSpy spy(m_corona, &Plasma::Corona::configSynced);
+
+    KConfigGroup group(m_corona->config(), QStringLiteral("AsyncSyncTest"));
+    group.writeEntry("first", 1);
+    m_corona->requireConfigSync();
+    group.writeEntry("second", 2);
+    // comes in while the first write is going on, gets written right after it
+    m_corona->requireConfigSync();
+    m_corona->requireConfigSync();
+
+    QTRY_VERIFY(spy.count() >= 2);
+
+    KConfig onDisk(m_configDir.filePath(QStringLiteral("plasma-test-appletsrc")), KConfig::SimpleConfig);
+    KConfigGroup onDiskGroup(&onDisk, QStringLiteral("AsyncSyncTest"));
+    QCOMPARE(onDiskGroup.readEntry("first", 0), 1);
+    QCOMPARE(onDiskGroup.readEntry("second", 0), 2);
+
+    // what got written is not dirty anymore, so a later sync does not write it back over other writers
+    QVERIFY(!m_corona->config()->isDirty());
+    onDiskGroup.writeEntry("first", 3);
+    onDisk.sync();
+    m_corona->setAsynchronousConfigSyncEnabled(false);
+    group.writeEntry("third", 3);
+    m_corona->requireConfigSync();
+    onDisk.reparseConfiguration();
+    QCOMPARE(onDiskGroup.readEntry("first", 0), 3);
+    QCOMPARE(onDiskGroup.readEntry("third", 0), 3);
+}
+
+void CoronaTest::configSyncPolicy()
+{
+    const Plasma::Corona::ConfigSyncPolicy oldPolicy = m_corona->configSyncPolicy();
+    Plasma::Corona::ConfigSyncPolicy policy;
+    policy.idleInterval = 50;
+    policy.maximumInterval = 200;
+    m_corona->setConfigSyncPolicy(policy);
+
+    const Plasma::Corona::ConfigSyncStatistics before = m_corona->configSyncStatistics();
+    QSignalSpy spy(m_corona, &Plasma::Corona::configSynced);
+
+    KConfigGroup group(m_corona->config(), QStringLiteral("SyncPolicyTest"));
+    // a burst of requests gets coalesced in a single sync
+    for (int i = 0; i < 10; ++i) {
+        group.writeEntry("value", i);
+        m_corona->requestConfigSync();
+    }
+    QTRY_COMPARE(spy.count(), 1);
+
+    const Plasma::Corona::ConfigSyncStatistics after = m_corona->configSyncStatistics();
+    QCOMPARE(after.syncs, before.syncs + 1);
+    QVERIFY(after.fileBytes > before.fileBytes);
+    QVERIFY(after.syncsLastMinute >= 1);
+    QVERIFY(after.lastLatency >= 0);
+
+    m_corona->setConfigSyncPolicy(oldPolicy);
+}
+
+void CoronaTest::lazyActivityLoading()
+{
+    {
+        KConfig layout(m_configDir.filePath(QStringLiteral("plasma-test-activities-appletsrc")), KConfig::SimpleConfig);
+        KConfigGroup containments(&layout, QStringLiteral("Containments"));
+        const QStringList activities = {QStringLiteral("first"), QStringLiteral("second"), QStringLiteral("second")};
+        for (int i = 0; i < activities.count(); ++i) {
+            KConfigGroup containment(&containments, QString::number(i + 1));
+            containment.writeEntry("plugin", QStringLiteral("simplecontainment"));
+            containment.writeEntry("activityId", activities.at(i));
+            containment.writeEntry("lastScreen", i);
+        }
+        KConfigGroup(&containments, QStringLiteral("3")).group(QStringLiteral("Applets")).group(QStringLiteral("100")).writeEntry("plugin", QStringLiteral("simpleapplet"));
+    }
+
+    SimpleCorona corona;
+    corona.setLazyActivityLoadingEnabled(true);
+    corona.setCurrentActivity(QStringLiteral("first"));
+    corona.loadLayout(QStringLiteral("plasma-test-activities-appletsrc"));
+
+    // only the current activity got created
+    QCOMPARE(corona.containments().count(), 1);
+    QCOMPARE(corona.containments().at(0)->id(), (uint)1);
+
+    // asking for a screen of another activity creates just what is there
+    QCOMPARE(corona.containmentForScreen(1, QStringLiteral("second"))->id(), (uint)2);
+    QCOMPARE(corona.containments().count(), 2);
+
+    // switching activity creates the rest of it
+    corona.setCurrentActivity(QStringLiteral("second"));
+    QCOMPARE(corona.containments().count(), 3);
+    QCOMPARE(corona.containments().at(2)->id(), (uint)3);
+}
+
+void CoronaTest::deferredApplets()
+{
+    {
+        KConfig layout(m_configDir.filePath(QStringLiteral("plasma-test-deferred-appletsrc")), KConfig::SimpleConfig);
+        KConfigGroup containments(&layout, QStringLiteral("Containments"));
+        const QStringList plugins = {QStringLiteral("simplecontainment"), QStringLiteral("simplenoscreencontainment")};
+        for (int i = 0; i < plugins.count(); ++i) {
+            KConfigGroup containment(&containments, QString::number(i + 1));
+            containment.writeEntry("plugin", plugins.at(i));
+            containment.writeEntry("lastScreen", 0);
+            containment.group(QStringLiteral("Applets")).group(QString::number(10 + i)).writeEntry("plugin", QStringLiteral("simpleapplet"));
+        }
+    }
+
+    SimpleCorona corona;
+    QSignalSpy spy(&corona, &Plasma::Corona::startupCompleted);
+    corona.loadLayout(QStringLiteral("plasma-test-deferred-appletsrc"));
+    QCOMPARE(corona.containments().count(), 2);
+
+    // what is on screen is there right away, the rest once the event loop runs
+    QCOMPARE(corona.containments().at(0)->applets().count(), 1);
+    QCOMPARE(corona.containments().at(1)->applets().count(), 0);
+    QVERIFY(!corona.containments().at(1)->isUiReady());
+
+    // startup still completes only with everything there
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(corona.containments().at(1)->applets().count(), 1);
+    QVERIFY(corona.containments().at(1)->isUiReady());
+}
+
+void CoronaTest::deferredAppletsUnknownScreen()
+{
+    KConfig layout(m_configDir.filePath(QStringLiteral("plasma-test-unknown-screen-appletsrc")), KConfig::SimpleConfig);
+    {
+        KConfigGroup containments(&layout, QStringLiteral("Containments"));
+        const QStringList plugins = {QStringLiteral("simplecontainment"), QStringLiteral("simplenoscreencontainment")};
+        for (int i = 0; i < plugins.count(); ++i) {
+            KConfigGroup containment(&containments, QString::number(i + 1));
+            containment.writeEntry("plugin", plugins.at(i));
+            containment.group(QStringLiteral("Applets")).group(QString::number(10 + i)).writeEntry("plugin", QStringLiteral("simpleapplet"));
+        }
+    }
+    QVERIFY(layout.sync());
+
+    // a corona not telling where its containments are doesn't hold any of them back
+    {
+        ScreenlessCorona corona;
+        corona.loadLayout(QStringLiteral("plasma-test-unknown-screen-appletsrc"));
+        QCOMPARE(corona.containments().count(), 2);
+        QCOMPARE(corona.containments().at(0)->applets().count(), 1);
+        QCOMPARE(corona.containments().at(1)->applets().count(), 1);
+    }
+
+    // merged layouts come back complete, even what is off screen
+    SimpleCorona corona;
+    corona.loadLayout(QStringLiteral("plasma-test-unknown-screen-target-appletsrc"));
+    const QList<Plasma::Containment *> imported = corona.importLayout(KConfigGroup(&layout, QString()));
+    QCOMPARE(imported.count(), 2);
+    QVERIFY(corona.isContainmentOffScreen(imported.at(1)));
+    QCOMPARE(imported.at(0)->applets().count(), 1);
+    QCOMPARE(imported.at(1)->applets().count(), 1);
+}
+
+void CoronaTest::layoutSnapshot()
+{
+    QVERIFY(QFile::copy(QStringLiteral(":/plasma-test-appletsrc"), m_configDir.filePath(QStringLiteral("plasma-test-snapshot-appletsrc"))));
+    const QString snapshotPath =
+        QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma/plasma-test-snapshot-appletsrc.layout");
+    QFile::remove(snapshotPath);
+
+    auto layoutOf = [](Plasma::Corona *corona) {
+        QList<uint> ids;
+        const auto containments = corona->containments();
+        for (auto containment : containments) {
+            ids << containment->id();
+            const auto applets = containment->applets();
+            for (auto applet : applets) {
+                ids << applet->id();
+            }
+        }
+        return ids;
+    };
+
+    QList<uint> layout;
+    {
+        SimpleCorona corona;
+        corona.loadLayout(QStringLiteral("plasma-test-snapshot-appletsrc"));
+        layout = layoutOf(&corona);
+        corona.requireConfigSync();
+    }
+    QVERIFY(QFile::exists(snapshotPath));
+
+    // restoring out of the snapshot gives the same layout
+    {
+        SimpleCorona corona;
+        corona.loadLayout(QStringLiteral("plasma-test-snapshot-appletsrc"));
+        QCOMPARE(layoutOf(&corona), layout);
+    }
+
+    // a stale snapshot is ignored
+    {
+        KConfig config(m_configDir.filePath(QStringLiteral("plasma-test-snapshot-appletsrc")), KConfig::SimpleConfig);
+        KConfigGroup(&config, QStringLiteral("Containments")).group(QStringLiteral("1")).group(QStringLiteral("Applets")).deleteGroup();
+    }
+    {
+        SimpleCorona corona;
+        corona.loadLayout(QStringLiteral("plasma-test-snapshot-appletsrc"));
+        QCOMPARE(corona.containments().count(), 3);
+        QCOMPARE(corona.containments().at(0)->applets().count(), 0);
+        corona.requireConfigSync();
+    }
+
+    // and so is one of a config edited in place, without changing its size or mtime
+    {
+        QFile file(m_configDir.filePath(QStringLiteral("plasma-test-snapshot-appletsrc")));
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        const QDateTime mtime = file.fileTime(QFileDevice::FileModificationTime);
+        QByteArray contents = file.readAll();
+        QVERIFY(contents.contains("[Containments][4]"));
+        contents.replace("[Containments][4]", "[Containments][6]");
+        QVERIFY(file.seek(0));
+        QCOMPARE(file.write(contents), contents.size());
+        file.close();
+        QVERIFY(file.setFileTime(mtime, QFileDevice::FileModificationTime));
+    }
+    {
+        SimpleCorona corona;
+        corona.loadLayout(QStringLiteral("plasma-test-snapshot-appletsrc"));
+        QCOMPARE(corona.containments().count(), 3);
+        QVERIFY(layoutOf(&corona).contains(6));
+        QVERIFY(!layoutOf(&corona).contains(4));
+    }
+}
+
+void CoronaTest::importLayout()
+{
+    KConfig layoutTemplate(m_configDir.filePath(QStringLiteral("plasma-test-template-appletsrc")), KConfig::SimpleConfig);
+    {
+        KConfigGroup containments(&layoutTemplate, QStringLiteral("Containments"));
+        for (int i = 1; i <= 4; ++i) {
+            KConfigGroup containment(&containments, QString::number(i));
+            containment.writeEntry("plugin", QStringLiteral("simplecontainment"));
+            containment.writeEntry("lastScreen", i);
+            KConfigGroup applet = containment.group(QStringLiteral("Applets")).group(QString::number(100 + i));
+            applet.writeEntry("plugin", QStringLiteral("simpleapplet"));
+            applet.group(QStringLiteral("Configuration")).writeEntry("value", i);
+        }
+    }
+    QVERIFY(layoutTemplate.sync());
+
+    SimpleCorona corona;
+    corona.loadLayout(QStringLiteral("plasma-test-template-target-appletsrc"));
+    QVERIFY(corona.containments().isEmpty());
+
+    const QList<Plasma::Containment *> imported = corona.importLayout(KConfigGroup(&layoutTemplate, QString()));
+    QCOMPARE(imported.count(), 4);
+    for (int i = 0; i < imported.count(); ++i) {
+        QCOMPARE(imported.at(i)->id(), uint(i + 1));
+        QCOMPARE(imported.at(i)->lastScreen(), i + 1);
+        QCOMPARE(imported.at(i)->applets().count(), 1);
+        const KConfigGroup merged =
+            KConfigGroup(corona.config(), QStringLiteral("Containments")).group(QString::number(i + 1)).group(QStringLiteral("Applets")).group(QString::number(101 + i));
+        QCOMPARE(merged.group(QStringLiteral("Configuration")).readEntry("value", 0), i + 1);
+    }
+
+    // importing it again, with unsaved changes, doesn't clash with what is there now
+    KConfigGroup(&layoutTemplate, QStringLiteral("Containments")).group(QStringLiteral("1")).writeEntry("lastScreen", 5);
+    const QList<Plasma::Containment *> again = corona.importLayout(KConfigGroup(&layoutTemplate, QString()));
+    QCOMPARE(again.count(), 4);
+    QCOMPARE(again.at(0)->lastScreen(), 5);
+    QVERIFY(again.at(0)->id() > 4);
+    QCOMPARE(corona.containments().count(), 8);
+}
+
+void CoronaTest::exportLayout()
+{
+    KConfig layoutTemplate(m_configDir.filePath(QStringLiteral("plasma-test-export-template-appletsrc")), KConfig::SimpleConfig);
+    KConfigGroup containments(&layoutTemplate, QStringLiteral("Containments"));
+    for (int i = 1; i <= 4; ++i) {
+        KConfigGroup containment(&containments, QString::number(i));
+        containment.writeEntry("plugin", QStringLiteral("simplecontainment"));
+        containment.group(QStringLiteral("Applets")).group(QString::number(100 + i)).writeEntry("plugin", QStringLiteral("simpleapplet"));
+    }
+
+    SimpleCorona corona;
+    corona.loadLayout(QStringLiteral("plasma-test-export-appletsrc"));
+    const QList<Plasma::Containment *> imported = corona.importLayout(KConfigGroup(&layoutTemplate, QString()));
+    QCOMPARE(imported.count(), 4);
+
+    const Plasma::Corona::ConfigSyncStatistics before = corona.configSyncStatistics();
+    KConfig exported(m_configDir.filePath(QStringLiteral("plasma-test-exported-appletsrc")), KConfig::SimpleConfig);
+    KConfigGroup exportedGroup(&exported, QString());
+    corona.exportLayout(exportedGroup, imported);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    // tearing all of them down costs a single sync
+    QCOMPARE(corona.configSyncStatistics().syncs, before.syncs + 1);
+    QVERIFY(corona.containments().isEmpty());
+    QVERIFY(!KConfigGroup(corona.config(), QStringLiteral("Containments")).hasGroup(QStringLiteral("1")));
+    QCOMPARE(KConfigGroup(&exported, QStringLiteral("Containments")).groupList().count(), 4);
+}
+
+void CoronaTest::exportTrace()
+{
+    const QString fileName = m_configDir.filePath(QStringLiteral("trace.json"));
+    QVERIFY(Plasma::Corona::exportTrace(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("traceEvents")).toArray();
+
+    QStringList names;
+    for (const QJsonValue &event : events) {
+        names << event.toObject().value(QStringLiteral("name")).toString();
+    }
+    // m_corona completed its startup in startupCompletion()
+    QVERIFY(names.contains(QLatin1String("startupCompleted")));
+    QVERIFY(names.contains(QLatin1String("containmentUiReady")));
+}
+
+void CoronaTest::loadingTimes()
+{
+    const QList<Plasma::Corona::LoadingTimes> times = m_corona->loadingTimes();
+    QVERIFY(!times.isEmpty());
+
+    bool foundContainment = false;
+    for (int i = 0; i < times.count(); ++i) {
+        // slowest first
+        if (i > 0) {
+            QVERIFY(times.at(i - 1).duration >= times.at(i).duration);
+        }
+        if (times.at(i).id == 1) {
+            foundContainment = true;
+            QVERIFY(times.at(i).isContainment);
+            QVERIFY(times.at(i).created >= 0);
+            QVERIFY(times.at(i).restored >= times.at(i).initialized);
+            // it became ready in startupCompletion()
+            QVERIFY(times.at(i).uiReady >= times.at(i).created);
+        }
+    }
+    QVERIFY(foundContainment);
+
+    QAbstractItemModel *model = m_corona->loadingTimesModel();
+    QMetaObject::invokeMethod(model, "refresh");
+    QCOMPARE(model->rowCount(), times.count());
+    QVERIFY(model->roleNames().values().contains("uiReady"));
+}
+
 // this test has to be the last, since systemimmutability
 // can't be programmatically unlocked
 void CoronaTest::immutability()
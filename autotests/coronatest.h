@@ -23,6 +23,18 @@ public:
 
     QRect screenGeometry(int) const override;
     int screenForContainment(const Plasma::Containment *) const override;
+    bool isContainmentOffScreen(const Plasma::Containment *) const override;
+};
+
+// knows nothing about the screens of its containments
+class ScreenlessCorona : public Plasma::Corona
+{
+    Q_OBJECT
+
+public:
+    explicit ScreenlessCorona(QObject *parent = nullptr);
+
+    QRect screenGeometry(int) const override;
 };
 
 class SimpleApplet : public Plasma::Applet
@@ -68,6 +80,21 @@ private Q_SLOTS:
     void checkOrder();
     void startupCompletion();
     void addRemoveApplets();
+    void addAppletsBatch();
+    void appletsStatus();
+    void constraintsFlush();
+    void containmentLookups();
+    void asynchronousRestore();
+    void asynchronousConfigSync();
+    void configSyncPolicy();
+    void lazyActivityLoading();
+    void deferredApplets();
+    void deferredAppletsUnknownScreen();
+    void layoutSnapshot();
+    void importLayout();
+    void exportLayout();
+    void exportTrace();
+    void loadingTimes();
     void immutability();
 
 private:
@@ -7,11 +7,16 @@
 #include "pluginloadertest.h"
 
 #include <QDebug>
+#include <QFile>
 #include <QSignalSpy>
+#include <QStandardPaths>
 #include <qtest.h>
 
 #include <KPluginMetaData>
 
+#include <plasma/applet.h>
+#include <plasma/containment.h>
+#include <plasma/containmentactions.h>
 #include <plasma/pluginloader.h>
 
 QTEST_MAIN(PluginTest)
@@ -20,6 +25,7 @@ PluginTest::PluginTest()
 {
     // To pick up the simpelcontianment dummy package
     qputenv("XDG_DATA_DIRS", QFINDTESTDATA("data/").toLocal8Bit().constData());
+    QStandardPaths::setTestModeEnabled(true);
 }
 
 void PluginTest::listContainmentActions()
@@ -40,4 +46,179 @@ void PluginTest::listContainmentsOfType()
     QVERIFY(pluginFound);
 }
 
+void PluginTest::listAppletsOfCategory()
+{
+    auto pluginIds = [](const QString &category) {
+        QStringList ids;
+        const QList<KPluginMetaData> plugins = Plasma::PluginLoader::self()->listAppletMetaData(category);
+        for (const KPluginMetaData &data : plugins) {
+            ids << data.pluginId();
+        }
+        return ids;
+    };
+
+    QVERIFY(pluginIds(QStringLiteral("Graphics")).contains(QLatin1String("testdropapplet")));
+    QVERIFY(!pluginIds(QStringLiteral("Graphics")).contains(QLatin1String("simplecontainment")));
+    QVERIFY(pluginIds(QStringLiteral("System Information")).contains(QLatin1String("simplecontainment")));
+    QVERIFY(!pluginIds(QStringLiteral("Miscellaneous")).contains(QLatin1String("testdropapplet")));
+
+    const QStringList all = pluginIds(QString());
+    QVERIFY(all.contains(QLatin1String("testdropapplet")));
+    QVERIFY(all.contains(QLatin1String("simplecontainment")));
+}
+
+void PluginTest::appletIndexCache()
+{
+    const QString cacheFile = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma/appletindex.cache");
+    QFile::remove(cacheFile);
+
+    Plasma::PluginLoader loader;
+    const QList<KPluginMetaData> plugins = loader.listAppletMetaData(QString());
+    QVERIFY(!plugins.isEmpty());
+    QVERIFY(QFile::exists(cacheFile));
+
+    // a new loader has to come up with the very same metadata out of the index on disk
+    Plasma::PluginLoader cachedLoader;
+    const QList<KPluginMetaData> cachedPlugins = cachedLoader.listAppletMetaData(QString());
+    QCOMPARE(cachedPlugins.count(), plugins.count());
+    for (int i = 0; i < plugins.count(); ++i) {
+        QCOMPARE(cachedPlugins.at(i).pluginId(), plugins.at(i).pluginId());
+        QCOMPARE(cachedPlugins.at(i).fileName(), plugins.at(i).fileName());
+        QCOMPARE(cachedPlugins.at(i).rawData(), plugins.at(i).rawData());
+    }
+}
+
+void PluginTest::pluginCacheStatistics()
+{
+    Plasma::PluginLoader loader;
+    for (int i = 0; i < 3; ++i) {
+        std::unique_ptr<Plasma::ContainmentActions> plugin(loader.loadContainmentActions(nullptr, QStringLiteral("dummycontainmentaction")));
+        QVERIFY(plugin);
+    }
+
+    // only the first lookup walks the plugin directories
+    const auto statistics = loader.containmentActionsPluginCacheStatistics();
+    QCOMPARE(statistics.misses, quint64(1));
+    QCOMPARE(statistics.hits, quint64(2));
+    QCOMPARE(statistics.invalidations, quint64(0));
+    // nothing was preloaded, every plugin got its factory loaded
+    QCOMPARE(statistics.factoryHits, quint64(0));
+    QCOMPARE(statistics.factoryMisses, quint64(3));
+}
+
+void PluginTest::containmentActionsCatalogue()
+{
+    Plasma::PluginLoader loader;
+    auto hasDummy = [](const QList<KPluginMetaData> &plugins) {
+        return std::any_of(plugins.begin(), plugins.end(), [](const KPluginMetaData &data) {
+            return data.pluginId() == QLatin1String("dummycontainmentaction");
+        });
+    };
+
+    QVERIFY(hasDummy(loader.listContainmentActionsMetaData(QStringLiteral("plasma-shell"))));
+    QVERIFY(hasDummy(loader.listContainmentActionsMetaData(QString())));
+    QVERIFY(!hasDummy(loader.listContainmentActionsMetaData(QStringLiteral("not-plasma-shell"))));
+
+    loader.preloadContainmentActions({QStringLiteral("dummycontainmentaction")});
+    std::unique_ptr<Plasma::ContainmentActions> plugin(loader.loadContainmentActions(nullptr, QStringLiteral("dummycontainmentaction")));
+    QVERIFY(plugin);
+    // once the preloaded factory landed, it has to be used from there on
+    auto loadFromFactory = [&loader, &plugin]() {
+        const quint64 factoryHits = loader.containmentActionsPluginCacheStatistics().factoryHits;
+        plugin.reset(loader.loadContainmentActions(nullptr, QStringLiteral("dummycontainmentaction")));
+        return plugin && loader.containmentActionsPluginCacheStatistics().factoryHits == factoryHits + 1;
+    };
+    QTRY_VERIFY(loadFromFactory());
+    QVERIFY(loadFromFactory());
+
+    // one directory walk for the whole catalogue
+    QCOMPARE(loader.containmentActionsPluginCacheStatistics().misses, quint64(1));
+
+    // preloading what is there already doesn't count as using it
+    const Plasma::PluginLoader::PluginCacheStatistics before = loader.containmentActionsPluginCacheStatistics();
+    loader.preloadContainmentActions({QStringLiteral("dummycontainmentaction")});
+    QTest::qWait(50);
+    QCOMPARE(loader.containmentActionsPluginCacheStatistics().factoryHits, before.factoryHits);
+    QCOMPARE(loader.containmentActionsPluginCacheStatistics().factoryMisses, before.factoryMisses);
+}
+
+void PluginTest::listAppletsForMimeType()
+{
+    auto hasDropApplet = [](const QList<KPluginMetaData> &plugins) {
+        return std::any_of(plugins.begin(), plugins.end(), [](const KPluginMetaData &data) {
+            return data.pluginId() == QLatin1String("testdropapplet");
+        });
+    };
+
+    auto loader = Plasma::PluginLoader::self();
+    QVERIFY(hasDropApplet(loader->listAppletMetaDataForMimeType(QStringLiteral("text/plain"))));
+    QVERIFY(!hasDropApplet(loader->listAppletMetaDataForMimeType(QStringLiteral("image/png"))));
+    QVERIFY(!hasDropApplet(loader->listAppletMetaDataForMimeType(QStringLiteral("video/mp4"), Plasma::PluginLoader::InheritedMimeTypeMatch)));
+
+    // image/* wildcard
+    QVERIFY(hasDropApplet(loader->listAppletMetaDataForMimeType(QStringLiteral("image/png"), Plasma::PluginLoader::InheritedMimeTypeMatch)));
+    // text/x-c++src inherits text/plain
+    QVERIFY(hasDropApplet(loader->listAppletMetaDataForMimeType(QStringLiteral("text/x-c++src"), Plasma::PluginLoader::InheritedMimeTypeMatch)));
+
+    const auto plugins = loader->listAppletMetaDataForMimeType(QStringLiteral("text/plain"), Plasma::PluginLoader::InheritedMimeTypeMatch);
+    const auto matches = std::count_if(plugins.begin(), plugins.end(), [](const KPluginMetaData &data) {
+        return data.pluginId() == QLatin1String("testdropapplet");
+    });
+    QCOMPARE(matches, qsizetype(1));
+}
+
+void PluginTest::listAppletsForUrl()
+{
+    auto dropApplets = [](const QUrl &url) {
+        const QList<KPluginMetaData> plugins = Plasma::PluginLoader::self()->listAppletMetaDataForUrl(url);
+        return std::count_if(plugins.begin(), plugins.end(), [](const KPluginMetaData &data) {
+            return data.pluginId() == QLatin1String("testdropapplet");
+        });
+    };
+
+    // both patterns match, the applet is listed only once
+    QCOMPARE(dropApplets(QUrl(QStringLiteral("https://www.example.org/index.html"))), qsizetype(1));
+    QCOMPARE(dropApplets(QUrl(QStringLiteral("https://docs.example.org/index.html"))), qsizetype(1));
+    QCOMPARE(dropApplets(QUrl(QStringLiteral("http://www.example.org/index.html"))), qsizetype(0));
+    QCOMPARE(dropApplets(QUrl(QStringLiteral("https://www.example.com/index.html"))), qsizetype(0));
+}
+
+void PluginTest::listAppletsForProvides()
+{
+    auto loader = Plasma::PluginLoader::self();
+    const QList<KPluginMetaData> plugins =
+        loader->listAppletMetaDataForProvides({QStringLiteral("org.kde.plasma.testdrop"), QStringLiteral("org.kde.plasma.nothingprovidesthis")});
+    QCOMPARE(plugins.count(), 1);
+    QCOMPARE(plugins.at(0).pluginId(), QStringLiteral("testdropapplet"));
+
+    QVERIFY(loader->listAppletMetaDataForProvides({QStringLiteral("org.kde.plasma.nothingprovidesthis")}).isEmpty());
+}
+
+void PluginTest::loadApplets()
+{
+    const QList<Plasma::PluginLoader::AppletSpec> specs{
+        {QStringLiteral("simplecontainment"), 0, {}},
+        {QString(), 0, {}},
+        {QStringLiteral("testdropapplet"), 4242, {}},
+        {QStringLiteral("simplecontainment"), 0, {}},
+    };
+
+    const QList<Plasma::Applet *> applets = Plasma::PluginLoader::self()->loadApplets(specs);
+    QCOMPARE(applets.count(), specs.count());
+    QVERIFY(!applets.at(1));
+
+    QVERIFY(qobject_cast<Plasma::Containment *>(applets.at(0)));
+    QCOMPARE(applets.at(0)->pluginMetaData().pluginId(), QStringLiteral("simplecontainment"));
+    QCOMPARE(applets.at(2)->pluginMetaData().pluginId(), QStringLiteral("testdropapplet"));
+    QCOMPARE(applets.at(2)->id(), uint(4242));
+    QCOMPARE(applets.at(3)->pluginMetaData().pluginId(), QStringLiteral("simplecontainment"));
+    // ids get assigned in order
+    QVERIFY(applets.at(0)->id() < applets.at(3)->id());
+    // both instances got the same package
+    QCOMPARE(applets.at(0)->kPackage().path(), applets.at(3)->kPackage().path());
+    QCOMPARE(applets.at(0)->kPackage().filePath("mainscript"), applets.at(3)->kPackage().filePath("mainscript"));
+
+    qDeleteAll(applets);
+}
+
 #include "moc_pluginloadertest.cpp"
@@ -18,6 +18,14 @@ public:
 private Q_SLOTS:
     void listContainmentActions();
     void listContainmentsOfType();
+    void listAppletsOfCategory();
+    void appletIndexCache();
+    void pluginCacheStatistics();
+    void containmentActionsCatalogue();
+    void listAppletsForMimeType();
+    void listAppletsForUrl();
+    void listAppletsForProvides();
+    void loadApplets();
 };
 
 #endif
@@ -37,6 +37,7 @@
 
 #include "debug_p.h"
 #include "private/containment_p.h"
+#include "private/tracer_p.h"
 
 #include <cmath>
 #include <limits>
@@ -74,7 +75,8 @@ Applet::~Applet()
     for (QAction *a : d->contextualActions) {
         disconnect(a, nullptr, this, nullptr);
     }
-    if (d->transient) {
+    // cleanUpAndDelete already did it, unless the config got accessed again since
+    if (d->transient && d->mainConfig) {
         d->resetConfigurationObject();
     }
     // let people know that i will die
@@ -538,6 +540,11 @@ void Applet::setStatus(const Types::ItemStatus status)
     Q_EMIT statusChanged(status);
 }
 
+void Applet::markQmlLoaded()
+{
+    d->qmlLoadedAt = Tracer::now();
+}
+
 void Applet::flushPendingConstraintsEvents()
 {
     if (d->pendingConstraints == NoConstraint) {
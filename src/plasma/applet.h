@@ -868,6 +868,11 @@ private:
      */
     Applet(const QString &packagePath, uint appletId);
 
+    /**
+     * @internal Records that the QML of the applet got loaded, for Corona::loadingTimes
+     */
+    void markQmlLoaded();
+
     // TODO KF6: drop Q_PRIVATE_SLOT
     Q_PRIVATE_SLOT(d, void cleanUpAndDelete())
     Q_PRIVATE_SLOT(d, void askDestroy())
@@ -23,10 +23,10 @@
 #include <QTemporaryFile>
 
 #include <KAuthorized>
-#include <KConfigLoader>
-#include <KConfigSkeleton>
 #include <KLocalizedString>
 
+#include <algorithm>
+
 #include <plasmaactivities/info.h>
 
 #include "containmentactions.h"
@@ -35,6 +35,7 @@
 #include "pluginloader.h"
 
 #include "private/applet_p.h"
+#include "private/corona_p.h"
 
 #include "plasma/plasma.h"
 
@@ -139,15 +140,6 @@ void Containment::init()
     });
 }
 
-// helper function for sorting the list of applets
-bool appletConfigLessThan(const KConfigGroup &c1, const KConfigGroup &c2)
-{
-    int i1 = c1.readEntry("id", 0);
-    int i2 = c2.readEntry("id", 0);
-
-    return (i1 < i2);
-}
-
 void Containment::restore(KConfigGroup &group)
 {
     /*
@@ -167,6 +159,12 @@ void Containment::restore(KConfigGroup &group)
 
     d->activityId = group.readEntry("activityId", QString());
 
+    // lastScreen and activityId changed behind the back of the signals the Corona follows
+    Corona *c = corona();
+    if (c && c->d->containmentIndexEntries.contains(this)) {
+        c->d->indexContainment(this);
+    }
+
     flushPendingConstraintsEvents();
     restoreContents(group);
     setImmutability((Types::ImmutabilityType)group.readEntry("immutability", (int)Types::Mutable));
@@ -239,8 +237,14 @@ void Containment::saveContents(KConfigGroup &group) const
 {
     KConfigGroup applets(&group, QStringLiteral("Applets"));
     for (const Applet *applet : std::as_const(d->applets)) {
+        if (d->savingChanges && !applet->d->configDirty) {
+            continue;
+        }
         KConfigGroup appletConfig(&applets, QString::number(applet->id()));
         applet->save(appletConfig);
+        if (d->savingChanges) {
+            applet->d->configDirty = !applet->d->started;
+        }
     }
 }
 
@@ -248,47 +252,67 @@ void Containment::restoreContents(KConfigGroup &group)
 {
     KConfigGroup applets(&group, QStringLiteral("Applets"));
 
-    // restore the applets ordered by id
-    QStringList groups = applets.groupList();
-    std::sort(groups.begin(), groups.end());
-
-    // Sort the applet configs in order of geometry to ensure that applets
-    // are added from left to right or top to bottom for a panel containment
-    QList<KConfigGroup> appletConfigs;
-    for (const QString &appletGroup : std::as_const(groups)) {
-        // qCDebug(LOG_PLASMA) << "reading from applet group" << appletGroup;
-        KConfigGroup appletConfig(&applets, appletGroup);
-        appletConfigs.append(appletConfig);
-    }
-    std::stable_sort(appletConfigs.begin(), appletConfigs.end(), appletConfigLessThan);
-
-    QMutableListIterator<KConfigGroup> it(appletConfigs);
-    while (it.hasNext()) {
-        KConfigGroup &appletConfig = it.next();
-        if (appletConfig.readEntry(QStringLiteral("transient"), false)) {
-            appletConfig.deleteGroup();
+    // the applets ordered by id, then by geometry, either out of the
+    // layout snapshot the corona got at startup or out of the config
+    QList<LayoutSnapshot::Applet> appletEntries;
+    Corona *c = corona();
+    if (!c || !c->d->takeSnapshotApplets(this, group, &appletEntries)) {
+        appletEntries = LayoutSnapshot::readApplets(applets);
+    }
+
+    const bool async = c && c->isAsynchronousLoadingEnabled();
+    QList<PluginLoader::AppletSpec> specs;
+
+    // applets get restored by the priority they ask for; those with a negative one
+    // and those of containments the corona reports off screen wait for the rest
+    QStringList plugins;
+    for (const LayoutSnapshot::Applet &entry : std::as_const(appletEntries)) {
+        plugins << entry.pluginName;
+    }
+    const QHash<QString, int> priorities = PluginLoader::self()->appletStartupPriorities(plugins);
+    std::stable_sort(appletEntries.begin(), appletEntries.end(), [&priorities](const LayoutSnapshot::Applet &a1, const LayoutSnapshot::Applet &a2) {
+        return priorities.value(a1.pluginName) > priorities.value(a2.pluginName);
+    });
+
+    // a containment in an applet, like the systray, is where its applet is
+    Applet *parentApplet = qobject_cast<Applet *>(parent());
+    const Containment *topLevel = parentApplet && parentApplet->containment() ? parentApplet->containment() : this;
+    // merged layouts give back their containments complete
+    const bool canDefer = c && !c->d->mergingLayout;
+    const bool offScreen = canDefer && c->isContainmentOffScreen(topLevel);
+    const bool onPanel = !offScreen && topLevel->d->isPanelContainment();
+
+    for (const LayoutSnapshot::Applet &entry : std::as_const(appletEntries)) {
+        if (entry.transient) {
+            KConfigGroup(&applets, entry.group).deleteGroup();
             continue;
         }
-        int appId = appletConfig.name().toUInt();
-        QString plugin = appletConfig.readEntry("plugin", QString());
+        int appId = entry.group.toUInt();
+        const QString &plugin = entry.pluginName;
 
         if (plugin.isEmpty()) {
             continue;
         }
 
-        d->createApplet(plugin, QVariantList(), appId);
-    }
+        const int priority = priorities.value(plugin);
+        if (canDefer && (offScreen || priority < 0)) {
+            ++d->deferredApplets;
+            c->d->scheduleDeferredApplet(this, PluginLoader::AppletSpec{plugin, appId, QVariantList()}, priority, onPanel);
+            continue;
+        }
 
-    // if there are no applets, none of them is "loading"
-    if (Containment::applets().isEmpty()) {
-        d->appletsUiReady = true;
-    }
-    const auto lstApplets = Containment::applets();
-    for (Applet *applet : lstApplets) {
-        if (!applet->pluginMetaData().isValid()) {
-            applet->updateConstraints(UiReadyConstraint);
+        if (async) {
+            d->createAppletAsync(plugin, appId);
+        } else {
+            specs << PluginLoader::AppletSpec{plugin, appId, QVariantList()};
         }
     }
+    d->createApplets(specs);
+
+    // otherwise processPendingApplets or restoreDeferredApplet finish once the last applet is there
+    if (!d->isRestoringApplets()) {
+        d->restoreContentsFinished();
+    }
 }
 
 Plasma::Containment::Type Containment::containmentType() const
@@ -371,106 +395,28 @@ Applet *Containment::createApplet(const QString &name, const QVariantList &args,
 
 void Containment::addApplet(Applet *applet, const QRectF &geometryHint)
 {
-    if (!applet) {
-#ifndef NDEBUG
-        // qCDebug(LOG_PLASMA) << "adding null applet!?!";
-#endif
-        return;
-    }
-
-    if (immutability() != Types::Mutable && !applet->property("org.kde.plasma:force-create").toBool()) {
-        return;
-    }
-
-#ifndef NDEBUG
-    if (d->applets.contains(applet)) {
-        // qCDebug(LOG_PLASMA) << "already have this applet!";
-    }
-#endif
-
-    Containment *currentContainment = applet->containment();
-
-    if (currentContainment && currentContainment != this) {
-        Q_EMIT currentContainment->appletAboutToBeRemoved(applet);
-        Q_EMIT currentContainment->appletRemoved(applet);
-        Q_EMIT appletsChanged();
-
-        disconnect(applet, nullptr, currentContainment, nullptr);
-        connect(currentContainment, nullptr, applet, nullptr);
-        KConfigGroup oldConfig = applet->config();
-        currentContainment->d->applets.removeAll(applet);
-        applet->setParent(this);
-
-        // now move the old config to the new location
-        // FIXME: this doesn't seem to get the actual main config group containing plugin=, etc
-        KConfigGroup c = config().group(QStringLiteral("Applets")).group(QString::number(applet->id()));
-        oldConfig.reparent(&c);
-        applet->d->resetConfigurationObject();
-
-        disconnect(applet, &Applet::activated, currentContainment, &Applet::activated);
-        // change the group to its configloader, if any
-        // FIXME: this is very, very brutal
-        if (applet->configScheme()) {
-            const QString oldGroupPrefix = QStringLiteral("Containments") + QString::number(currentContainment->id()) + QStringLiteral("Applets");
-            const QString newGroupPrefix = QStringLiteral("Containments") + QString::number(id()) + QStringLiteral("Applets");
-
-            applet->configScheme()->setCurrentGroup(applet->configScheme()->currentGroup().replace(0, oldGroupPrefix.length(), newGroupPrefix));
-
-            const auto items = applet->configScheme()->items();
-            for (KConfigSkeletonItem *item : items) {
-                item->setGroup(item->group().replace(0, oldGroupPrefix.length(), newGroupPrefix));
-            }
-        }
-    } else {
-        applet->setParent(this);
-    }
-
-    // make sure the applets are sorted by id
-    auto position = std::lower_bound(d->applets.begin(), d->applets.end(), applet, [](Plasma::Applet *a1, Plasma::Applet *a2) {
-        return a1->id() < a2->id();
-    });
-    Q_EMIT appletAboutToBeAdded(applet, geometryHint);
-    d->applets.insert(position, applet);
-
-    if (!d->uiReady) {
-        d->loadingApplets << applet;
-    }
-
-    connect(applet, &Applet::configNeedsSaving, this, &Applet::configNeedsSaving);
-    connect(applet, SIGNAL(appletDeleted(Plasma::Applet *)), this, SLOT(appletDeleted(Plasma::Applet *)));
-    connect(applet, SIGNAL(statusChanged(Plasma::Types::ItemStatus)), this, SLOT(checkStatus(Plasma::Types::ItemStatus)));
-    connect(applet, &Applet::activated, this, &Applet::activated);
-    connect(this, &Containment::containmentDisplayHintsChanged, applet, &Applet::containmentDisplayHintsChanged);
-
-    if (!currentContainment) {
-        const bool isNew = applet->d->mainConfigGroup()->entryMap().isEmpty();
-
-        if (!isNew) {
-            applet->restore(*applet->d->mainConfigGroup());
-        }
+    d->addApplets({applet}, geometryHint);
+}
 
-        applet->init();
+void Containment::addApplets(const QList<Applet *> &applets)
+{
+    d->addApplets(applets, QRectF());
+}
 
-        if (isNew) {
-            applet->save(*applet->d->mainConfigGroup());
-            Q_EMIT configNeedsSaving();
-        }
-        // FIXME: an on-appear animation would be nice to have again
+void Containment::removeApplets(const QList<Applet *> &applets)
+{
+    if (!d->removeApplets(applets)) {
+        return;
     }
-
-    applet->updateConstraints(AllConstraints);
-    applet->flushPendingConstraintsEvents();
-
-    Q_EMIT appletAdded(applet, geometryHint);
     Q_EMIT appletsChanged();
-    Q_EMIT applet->containmentChanged(this);
+    Q_EMIT configNeedsSaving();
 
-    if (!currentContainment) {
-        applet->updateConstraints(StartupCompletedConstraint);
-        applet->flushPendingConstraintsEvents();
+    // they are not in applets() anymore, so deleting them notifies nothing else
+    for (Applet *applet : applets) {
+        if (applet && applet->containment() == this) {
+            applet->d->cleanUpAndDelete();
+        }
     }
-
-    applet->d->scheduleModificationNotification();
 }
 
 QList<Applet *> Containment::applets() const
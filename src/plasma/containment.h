@@ -177,6 +177,30 @@ public:
      */
     Q_INVOKABLE void addApplet(Applet *applet, const QRectF &geometryHint = QRectF());
 
+    /**
+     * Add several existing applets to this Containment at once.
+     *
+     * appletAboutToBeAdded and appletAdded are emitted for each of them,
+     * appletsChanged only once at the end, after appletsInserted told where
+     * they ended up in applets()
+     *
+     * @param applets the applets that should be added
+     * @since 6.0
+     */
+    Q_INVOKABLE void addApplets(const QList<Plasma::Applet *> &applets);
+
+    /**
+     * Remove several applets of this Containment at once, deleting them
+     * together with their configuration.
+     *
+     * appletAboutToBeRemoved, appletRemoved and appletsRemoved are emitted for
+     * each of them, appletsChanged only once at the end, before they get deleted
+     *
+     * @param applets the applets that should be removed
+     * @since 6.0
+     */
+    Q_INVOKABLE void removeApplets(const QList<Plasma::Applet *> &applets);
+
     /**
      * @return the applets currently in this Containment
      */
@@ -327,6 +351,27 @@ Q_SIGNALS:
      */
     void appletsChanged();
 
+    /**
+     * Emitted when applets got added, before appletsChanged.
+     * Applets added together which don't end up next to each other in
+     * applets() cause one emission for each run, in ascending order
+     * @param first the position of the first added applet in applets()
+     * @param last the position of the last added applet in applets()
+     * @since 6.0
+     */
+    void appletsInserted(int first, int last);
+
+    /**
+     * Emitted when applets got removed, before appletsChanged. Applets removed
+     * together with removeApplets() are followed by a single appletsChanged,
+     * and notified from the last position to the first: each position is the
+     * same before and after the removals of the same batch notified before it
+     * @param first the position of the first removed applet in applets(), before the removal
+     * @param last the position of the last removed applet in applets(), before the removal
+     * @since 6.0
+     */
+    void appletsRemoved(int first, int last);
+
     /**
      * Emitted when the activity id has changed
      */
@@ -11,23 +11,29 @@
 #include "private/corona_p.h"
 
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <QGuiApplication>
 #include <QJSEngine>
 #include <QMimeData>
 #include <QPainter>
 #include <QScreen>
+#include <QStandardPaths>
 #include <QTimer>
 
 #include <KLocalizedString>
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include "containment.h"
 #include "debug_p.h"
 #include "pluginloader.h"
 #include "private/applet_p.h"
 #include "private/containment_p.h"
-#include "private/timetracker.h"
+#include "private/loadingtimesmodel_p.h"
+#include "private/tracer_p.h"
 
 using namespace Plasma;
 
@@ -38,12 +44,6 @@ Corona::Corona(QObject *parent)
     , d(new CoronaPrivate(this))
 {
     d->init();
-
-#ifndef NDEBUG
-    if (qEnvironmentVariableIsSet("PLASMA_TRACK_STARTUP")) {
-        new TimeTracker(this);
-    }
-#endif
 }
 
 Corona::~Corona()
@@ -90,6 +90,9 @@ void Corona::exportLayout(KConfigGroup &config, QList<Containment *> containment
     Types::ImmutabilityType oldImm = immutability();
     d->immutability = Types::Mutable;
 
+    // every destroyed containment asks for a sync of our config, do only one at the end
+    const bool wasSuspended = std::exchange(d->configSyncSuspended, true);
+
     KConfigGroup dest(&config, QStringLiteral("Containments"));
     KConfigGroup dummy;
     for (Plasma::Containment *c : std::as_const(containments)) {
@@ -110,25 +113,29 @@ void Corona::exportLayout(KConfigGroup &config, QList<Containment *> containment
     // restore immutability
     d->immutability = oldImm;
 
+    d->configSyncSuspended = wasSuspended;
+    if (!wasSuspended && std::exchange(d->configSyncDeferred, false)) {
+        d->syncConfig();
+    }
+
     config.sync();
 }
 
 void Corona::requestConfigSync()
 {
-    // constant controlling how long between requesting a configuration sync
-    // and one happening should occur. currently 10 seconds
-    static const int CONFIG_SYNC_TIMEOUT = 10000;
-
     // TODO: should we check into our immutability before doing this?
 
-    // NOTE: this is a pretty simplistic model: we simply save no more than CONFIG_SYNC_TIMEOUT
-    //      after the first time this is called. not much of a heuristic for save points, but
-    //      it should at least compress these activities a bit and provide a way for applet
-    //      authors to ween themselves from the sync() disease. A more interesting/dynamic
-    //      algorithm for determining when to actually sync() to disk might be better, though.
-    if (!d->configSyncTimer->isActive()) {
-        d->configSyncTimer->start(CONFIG_SYNC_TIMEOUT);
+    // NOTE: every request pushes the sync back until things calm down, which compresses
+    //      bursts like dragging an applet around in a single sync, while the maximum
+    //      interval still bounds how long a change can wait for being written
+    if (!d->pendingConfigSync.isValid()) {
+        d->pendingConfigSync.start();
     }
+
+    const ConfigSyncPolicy &policy = d->configSyncPolicy;
+    const qint64 idleInterval = d->editMode ? policy.editModeIdleInterval : policy.idleInterval;
+    const qint64 remaining = policy.maximumInterval - d->pendingConfigSync.elapsed();
+    d->configSyncTimer->start(int(std::clamp<qint64>(std::min(idleInterval, remaining), 0, policy.maximumInterval)));
 }
 
 void Corona::requireConfigSync()
@@ -146,6 +153,17 @@ void Corona::loadLayout(const QString &configName)
 
     KConfigGroup conf(config(), QString());
     if (!config()->groupList().isEmpty()) {
+        // what to create and in which order, without walking all the groups if the file did not change since the last sync.
+        // Unsynced changes in memory are not in the file the snapshot was taken from
+        if (!config()->isDirty()) {
+            d->layoutSnapshot = LayoutSnapshot::load(d->configFilePath());
+        }
+        // otherwise the config gets parsed once, here, for both prefetching and restoring
+        if (!d->layoutSnapshot) {
+            d->layoutSnapshot = LayoutSnapshot::read(conf, true);
+        }
+        // get the plugins off the disk while the containments are being created
+        d->prefetchLayoutPlugins(conf);
         d->importLayout(conf, false);
     } else {
         loadDefaultLayout();
@@ -163,15 +181,30 @@ QList<Plasma::Containment *> Corona::importLayout(const KConfigGroup &conf)
 
 Containment *Corona::containmentForScreen(int screen, const QString &activity, const QString &defaultPluginIfNonExistent, const QVariantList &defaultArgs)
 {
-    Containment *containment = nullptr;
+    d->materializeContainments([screen, &activity](const QString &placeholderActivity, int lastScreen) {
+        return lastScreen == screen && (activity.isEmpty() || placeholderActivity == activity);
+    });
 
-    for (Containment *cont : std::as_const(d->containments)) {
-        if (cont->lastScreen() == screen //
-            && ((cont->activity().isEmpty() || activity.isEmpty()) || cont->activity() == activity)
-            && (cont->containmentType() == Plasma::Containment::Type::Desktop //
-                || cont->containmentType() == Plasma::Containment::Type::Custom || cont->containmentType() == Plasma::Containment::Type::NoContainment)) {
-            containment = cont;
+    auto findContainment = [this, screen, &activity]() -> Containment * {
+        Containment *containment = nullptr;
+        const QList<Containment *> candidates = d->containmentsByLastScreen.value(screen);
+        for (Containment *cont : candidates) {
+            if (cont->lastScreen() == screen //
+                && ((cont->activity().isEmpty() || activity.isEmpty()) || cont->activity() == activity)
+                && (cont->containmentType() == Plasma::Containment::Type::Desktop //
+                    || cont->containmentType() == Plasma::Containment::Type::Custom
+                    || cont->containmentType() == Plasma::Containment::Type::NoContainment)) {
+                containment = cont;
+            }
         }
+        return containment;
+    };
+    Containment *containment = findContainment();
+
+    // the one we are looking for may still be loading, don't create a duplicate of it
+    if (!containment && !defaultPluginIfNonExistent.isEmpty() && !d->pendingContainments.isEmpty()) {
+        d->finishPendingContainments();
+        containment = findContainment();
     }
 
     if (!containment && !defaultPluginIfNonExistent.isEmpty()) {
@@ -199,7 +232,12 @@ QList<Containment *> Corona::containmentsForActivity(const QString &activity)
         return conts;
     }
 
-    std::copy_if(d->containments.begin(), d->containments.end(), std::back_inserter(conts), [activity](Containment *cont) {
+    d->materializeContainments([&activity](const QString &placeholderActivity, int) {
+        return placeholderActivity == activity;
+    });
+
+    const QList<Containment *> candidates = d->containmentsByActivity.value(activity);
+    std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(conts), [activity](Containment *cont) {
         return cont->activity() == activity
             && (cont->containmentType() == Plasma::Containment::Type::Desktop || cont->containmentType() == Plasma::Containment::Type::Custom);
     });
@@ -215,7 +253,12 @@ QList<Containment *> Corona::containmentsForScreen(int screen)
         return conts;
     }
 
-    std::copy_if(d->containments.begin(), d->containments.end(), std::back_inserter(conts), [screen](Containment *cont) {
+    d->materializeContainments([screen](const QString &, int lastScreen) {
+        return lastScreen == screen;
+    });
+
+    const QList<Containment *> candidates = d->containmentsByLastScreen.value(screen);
+    std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(conts), [screen](Containment *cont) {
         return cont->lastScreen() == screen
             && (cont->containmentType() == Plasma::Containment::Type::Desktop //
                 || cont->containmentType() == Plasma::Containment::Type::Custom);
@@ -266,6 +309,11 @@ int Corona::screenForContainment(const Containment *) const
     return -1;
 }
 
+bool Corona::isContainmentOffScreen(const Containment *) const
+{
+    return false;
+}
+
 int Corona::numScreens() const
 {
     return 1;
@@ -381,6 +429,155 @@ bool Corona::isEditMode() const
     return d->editMode;
 }
 
+void Corona::setAsynchronousLoadingEnabled(bool enabled)
+{
+    d->asynchronousLoading = enabled;
+}
+
+bool Corona::isAsynchronousLoadingEnabled() const
+{
+    return d->asynchronousLoading;
+}
+
+void Corona::setAsynchronousConfigSyncEnabled(bool enabled)
+{
+    d->asynchronousConfigSync = enabled;
+}
+
+bool Corona::isAsynchronousConfigSyncEnabled() const
+{
+    return d->asynchronousConfigSync;
+}
+
+void Corona::setConfigSyncPolicy(const ConfigSyncPolicy &policy)
+{
+    d->configSyncPolicy = policy;
+}
+
+Corona::ConfigSyncPolicy Corona::configSyncPolicy() const
+{
+    return d->configSyncPolicy;
+}
+
+void Corona::setLazyActivityLoadingEnabled(bool enabled)
+{
+    d->lazyActivityLoading = enabled;
+    if (!enabled) {
+        d->hibernationTimer->stop();
+        d->materializeContainments([](const QString &, int) {
+            return true;
+        });
+    }
+}
+
+bool Corona::isLazyActivityLoadingEnabled() const
+{
+    return d->lazyActivityLoading;
+}
+
+void Corona::setCurrentActivity(const QString &activity)
+{
+    if (d->currentActivity == activity) {
+        return;
+    }
+
+    d->currentActivity = activity;
+    if (!d->lazyActivityLoading) {
+        return;
+    }
+
+    d->materializeContainments([&activity](const QString &placeholderActivity, int) {
+        return placeholderActivity == activity;
+    });
+    if (d->hibernationTimer->interval() > 0) {
+        d->hibernationTimer->start();
+    }
+}
+
+QString Corona::currentActivity() const
+{
+    return d->currentActivity;
+}
+
+void Corona::setContainmentHibernationTimeout(int msec)
+{
+    d->hibernationTimer->setInterval(std::max(msec, 0));
+    if (msec <= 0) {
+        d->hibernationTimer->stop();
+    }
+}
+
+int Corona::containmentHibernationTimeout() const
+{
+    return d->hibernationTimer->interval();
+}
+
+bool Corona::exportTrace(const QString &fileName)
+{
+    return Tracer::exportChromeTrace(fileName);
+}
+
+QList<Corona::LoadingTimes> Corona::loadingTimes() const
+{
+    const qint64 now = Tracer::now();
+    auto sinceCreation = [this](qint64 time) -> qint64 {
+        return time < 0 ? -1 : (time - d->creationTime) / 1000000;
+    };
+    auto timesOf = [&](Applet *applet, Containment *containment) {
+        const AppletPrivate *p = applet->d;
+        LoadingTimes times;
+        times.id = applet->id();
+        times.containmentId = containment->id();
+        times.pluginName = applet->pluginName();
+        times.isContainment = applet == containment;
+        times.created = sinceCreation(p->createdAt);
+        times.initialized = sinceCreation(p->initializedAt);
+        times.restored = sinceCreation(p->restoredAt);
+        times.qmlLoaded = sinceCreation(p->qmlLoadedAt);
+        times.uiReadyConstraint = sinceCreation(p->uiReadyConstraintAt);
+        times.uiReady = sinceCreation(p->uiReadyAt);
+        times.duration = ((p->uiReadyAt < 0 ? now : p->uiReadyAt) - p->createdAt) / 1000000;
+        return times;
+    };
+
+    QList<LoadingTimes> list;
+    for (Containment *containment : std::as_const(d->containments)) {
+        list << timesOf(containment, containment);
+        const QList<Applet *> applets = containment->applets();
+        for (Applet *applet : applets) {
+            list << timesOf(applet, containment);
+        }
+    }
+
+    std::stable_sort(list.begin(), list.end(), [](const LoadingTimes &t1, const LoadingTimes &t2) {
+        return t1.duration > t2.duration;
+    });
+    return list;
+}
+
+QAbstractItemModel *Corona::loadingTimesModel() const
+{
+    if (!d->loadingTimesModel) {
+        d->loadingTimesModel = new LoadingTimesModel(const_cast<Corona *>(this));
+    }
+    return d->loadingTimesModel;
+}
+
+Corona::ConfigSyncStatistics Corona::configSyncStatistics() const
+{
+    ConfigSyncStatistics statistics = d->configSyncStatistics;
+    const qint64 minuteAgo = d->uptime.elapsed() - 60000;
+    statistics.syncsLastMinute = int(std::count_if(d->recentConfigSyncs.cbegin(), d->recentConfigSyncs.cend(), [minuteAgo](qint64 time) {
+        return time > minuteAgo;
+    }));
+    return statistics;
+}
+
+Corona::ConstraintsStatistics Corona::constraintsStatistics() const
+{
+    return d->constraintsStatistics;
+}
+
 QList<Plasma::Types::Location> Corona::freeEdges(int screen) const
 {
     QList<Plasma::Types::Location> freeEdges;
@@ -391,12 +588,12 @@ QList<Plasma::Types::Location> Corona::freeEdges(int screen) const
               << Plasma::Types::RightEdge;
     /* clang-format on */
 
-    const auto containments = this->containments();
-    for (Containment *containment : containments) {
-        if (containment->screen() == screen && freeEdges.contains(containment->location())) {
-            freeEdges.removeAll(containment->location());
-        }
-    }
+    freeEdges.removeIf([this, screen](Plasma::Types::Location location) {
+        const QList<Containment *> candidates = d->containmentsByLocation.value(location);
+        return std::any_of(candidates.begin(), candidates.end(), [screen](Containment *containment) {
+            return containment->screen() == screen;
+        });
+    });
 
     return freeEdges;
 }
@@ -442,9 +639,18 @@ CoronaPrivate::CoronaPrivate(Corona *corona)
     , config(nullptr)
     , configSyncTimer(new QTimer(corona))
     , containmentsStarting(0)
+    , hibernationTimer(new QTimer(corona))
+    , creationTime(Tracer::now())
+    , constraintsTimer(new QTimer(corona))
+    , deferredAppletsTimer(new QTimer(corona))
 {
     // TODO: make Package path configurable
 
+    // a single thread, so that snapshots land in the order they were taken
+    configWriter.setMaxThreadCount(1);
+    configWriter.setExpiryTimeout(-1);
+    uptime.start();
+
     if (QCoreApplication::instance()) {
         configName = QCoreApplication::instance()->applicationName() + QStringLiteral("-appletsrc");
     } else {
@@ -454,6 +660,14 @@ CoronaPrivate::CoronaPrivate(Corona *corona)
 
 CoronaPrivate::~CoronaPrivate()
 {
+    configWriter.waitForDone();
+    for (PendingContainment &pending : pendingContainments) {
+        if (pending.future.isFinished()) {
+            delete pending.future.result();
+        } else {
+            pending.future.cancel();
+        }
+    }
     qDeleteAll(containments);
 }
 
@@ -464,6 +678,28 @@ void CoronaPrivate::init()
     configSyncTimer->setSingleShot(true);
     QObject::connect(configSyncTimer, SIGNAL(timeout()), q, SLOT(syncConfig()));
 
+    QObject::connect(q, &Corona::startupCompleted, q, [this]() {
+        Tracer::span("startupCompleted", creationTime);
+    });
+
+    hibernationTimer->setSingleShot(true);
+    hibernationTimer->setInterval(0);
+    QObject::connect(hibernationTimer, &QTimer::timeout, q, [this]() {
+        hibernateContainments();
+    });
+
+    constraintsTimer->setSingleShot(true);
+    constraintsTimer->setInterval(0);
+    QObject::connect(constraintsTimer, &QTimer::timeout, q, [this]() {
+        flushPendingConstraints();
+    });
+
+    deferredAppletsTimer->setSingleShot(true);
+    deferredAppletsTimer->setInterval(0);
+    QObject::connect(deferredAppletsTimer, &QTimer::timeout, q, [this]() {
+        restoreDeferredApplet();
+    });
+
     QAction *lockAction = new QAction(q);
     q->setAction(QStringLiteral("lock widgets"), lockAction);
     QObject::connect(lockAction, SIGNAL(triggered(bool)), q, SLOT(toggleImmutability()));
@@ -500,11 +736,29 @@ void CoronaPrivate::toggleImmutability()
 
 void CoronaPrivate::saveLayout(KSharedConfigPtr cg) const
 {
+    // saving to our own config, which already has whatever did not change since the last save
+    const bool onlyChanges = cg == q->config();
+
     KConfigGroup containmentsGroup(cg, QStringLiteral("Containments"));
-    for (const Containment *containment : containments) {
+    for (Containment *containment : containments) {
         QString cid = QString::number(containment->id());
         KConfigGroup containmentConfig(&containmentsGroup, cid);
-        containment->save(containmentConfig);
+        if (onlyChanges) {
+            containment->d->saveChanges(containmentConfig);
+        } else {
+            containment->save(containmentConfig);
+        }
+    }
+
+    if (onlyChanges) {
+        return;
+    }
+    // the containments not created yet are only in our own config
+    const KConfigGroup ownContainments(q->config(), QStringLiteral("Containments"));
+    for (auto it = containmentPlaceholders.cbegin(); it != containmentPlaceholders.cend(); ++it) {
+        const QString cid = QString::number(it.key());
+        KConfigGroup containmentConfig(&containmentsGroup, cid);
+        KConfigGroup(&ownContainments, cid).copyTo(&containmentConfig);
     }
 }
 
@@ -527,32 +781,259 @@ void CoronaPrivate::containmentDestroyed(QObject *obj)
 
     if (index > -1) {
         containments.removeAt(index);
+        unindexContainment(containment);
         q->requestConfigSync();
     }
 }
 
+static void insertSortedById(QList<Containment *> &list, Containment *containment)
+{
+    auto position = std::lower_bound(list.begin(), list.end(), containment, [](Plasma::Containment *c1, Plasma::Containment *c2) {
+        return c1->id() < c2->id();
+    });
+    list.insert(position, containment);
+}
+
+void CoronaPrivate::indexContainment(Containment *containment)
+{
+    unindexContainment(containment);
+
+    ContainmentIndexEntry entry;
+    entry.lastScreen = containment->lastScreen();
+    entry.activity = containment->activity();
+    entry.location = containment->location();
+
+    insertSortedById(containmentsByLastScreen[entry.lastScreen], containment);
+    insertSortedById(containmentsByActivity[entry.activity], containment);
+    insertSortedById(containmentsByLocation[entry.location], containment);
+    containmentIndexEntries.insert(containment, entry);
+}
+
+void CoronaPrivate::unindexContainment(Containment *containment)
+{
+    // may be called from the destroyed signal: don't touch anything but the pointer
+    const auto it = containmentIndexEntries.constFind(containment);
+    if (it == containmentIndexEntries.cend()) {
+        return;
+    }
+    const ContainmentIndexEntry entry = it.value();
+    containmentIndexEntries.erase(it);
+
+    auto removeFrom = [containment](auto &index, const auto &key) {
+        auto bucket = index.find(key);
+        if (bucket != index.end()) {
+            bucket->removeOne(containment);
+            if (bucket->isEmpty()) {
+                index.erase(bucket);
+            }
+        }
+    };
+    removeFrom(containmentsByLastScreen, entry.lastScreen);
+    removeFrom(containmentsByActivity, entry.activity);
+    removeFrom(containmentsByLocation, entry.location);
+}
+
 void CoronaPrivate::syncConfig()
 {
-    q->config()->sync();
+    // whatever was requested until now gets written with this sync
+    configSyncTimer->stop();
+    pendingConfigSync.invalidate();
+
+    if (configSyncSuspended) {
+        configSyncDeferred = true;
+        return;
+    }
+
+    if (!asynchronousConfigSync) {
+        QElapsedTimer timer;
+        timer.start();
+        const KSharedConfigPtr cg = q->config();
+        const QString path = configFilePath();
+        const bool changed = cg->isDirty() || !QFileInfo::exists(LayoutSnapshot::filePath(path));
+        if (cg->sync() && changed) {
+            LayoutSnapshot::save(cg.data(), path);
+        }
+        recordConfigSync(timer.elapsed(), QFileInfo(path).size());
+        Q_EMIT q->configSynced();
+        return;
+    }
+
+    // the snapshot taken once the current write lands covers this request too
+    if (configWriteInFlight) {
+        configSyncPending = true;
+        return;
+    }
+
+    writeConfigSnapshot();
+}
+
+void CoronaPrivate::recordConfigSync(qint64 latency, qint64 bytes)
+{
+    ++configSyncStatistics.syncs;
+    configSyncStatistics.fileBytes += bytes;
+    configSyncStatistics.lastLatency = latency;
+    configSyncStatistics.maximumLatency = std::max(configSyncStatistics.maximumLatency, latency);
+
+    const qint64 now = uptime.elapsed();
+    recentConfigSyncs.removeIf([now](qint64 time) {
+        return time <= now - 60000;
+    });
+    recentConfigSyncs << now;
+
+    qCDebug(LOG_PLASMA) << "Config synced in" << latency << "ms," << bytes << "bytes;" << recentConfigSyncs.count() << "syncs in the last minute";
+}
+
+QString CoronaPrivate::configFilePath() const
+{
+    const QString name = q->config()->name();
+    if (QDir::isAbsolutePath(name)) {
+        return name;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1Char('/') + name;
+}
+
+void CoronaPrivate::writeConfigSnapshot()
+{
+    // KConfig is not thread safe: copy it here, serialize and write the copy on the writer thread.
+    // The copy has all of the entries, so the live config is clean from here on: a later sync
+    // writes only what changed since, rather than stale values over what others wrote meanwhile
+    const KSharedConfigPtr cg = q->config();
+    configWriteTimer.start();
+    KConfig *snapshot = cg->copyTo(cg->name());
+    cg->markAsClean();
+    configWriteInFlight = true;
+
+    configWriter.start([this, snapshot, path = configFilePath()]() {
+        const bool written = snapshot->sync();
+        if (written) {
+            LayoutSnapshot::save(snapshot, path);
+        }
+        delete snapshot;
+        const qint64 bytes = QFileInfo(path).size();
+        QMetaObject::invokeMethod(
+            q,
+            [this, written, bytes]() {
+                configSnapshotWritten(written, bytes);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void CoronaPrivate::configSnapshotWritten(bool written, qint64 bytes)
+{
+    configWriteInFlight = false;
+    recordConfigSync(configWriteTimer.elapsed(), bytes);
     Q_EMIT q->configSynced();
+
+    // the live config got marked clean already, another snapshot has to carry what got lost
+    if (!written) {
+        qCWarning(LOG_PLASMA) << "Could not write the config to" << configFilePath();
+        if (!configSyncPending) {
+            configSyncTimer->start(configSyncPolicy.maximumInterval);
+        }
+    }
+
+    if (configSyncPending) {
+        configSyncPending = false;
+        writeConfigSnapshot();
+    }
+}
+
+QString CoronaPrivate::containmentPluginName(const QString &name) const
+{
+    if (name.isEmpty() || name == QLatin1String("default")) {
+        // default to the desktop containment
+        return desktopDefaultsConfig.readEntry("Containment", "org.kde.desktopcontainment");
+    }
+    return name;
 }
 
 Containment *CoronaPrivate::addContainment(const QString &name, const QVariantList &args, uint id, int lastScreen, bool delayedInit)
 {
-    QString pluginName = name;
-    Containment *containment = nullptr;
+    const QString pluginName = containmentPluginName(name);
     Applet *applet = nullptr;
 
     // qCDebug(LOG_PLASMA) << "Loading" << name << args << id;
 
-    if (pluginName.isEmpty() || pluginName == QLatin1String("default")) {
-        // default to the desktop containment
-        pluginName = desktopDefaultsConfig.readEntry("Containment", "org.kde.desktopcontainment");
+    if (pluginName != QLatin1String("null")) {
+        applet = PluginLoader::self()->loadApplet(pluginName, id, args);
+    }
+
+    return setupContainment(applet, pluginName, id, lastScreen, delayedInit);
+}
+
+void CoronaPrivate::addContainmentAsync(const QString &name, uint id)
+{
+    const QString pluginName = containmentPluginName(name);
+
+    // an empty name gives back an already finished future with no applet, which is what a null containment wants
+    QFuture<Applet *> future = PluginLoader::self()->loadAppletAsync(pluginName == QLatin1String("null") ? QString() : pluginName, id);
+    pendingContainments << PendingContainment{future, pluginName, id};
+    future.then(q, [this](Applet *) {
+        processPendingContainments();
+    });
+}
+
+void CoronaPrivate::processPendingContainments()
+{
+    if (pendingContainments.isEmpty()) {
+        return;
+    }
+
+    // keep the order they were imported in, no matter which plugin finished loading first
+    while (!pendingContainments.isEmpty() && pendingContainments.first().future.isFinished()) {
+        const PendingContainment pending = pendingContainments.takeFirst();
+
+        // restoring the layout bypasses immutability, as the synchronous import
+        // happens before the immutability of the corona is loaded
+        const Types::ImmutabilityType imm = immutability;
+        immutability = Types::Mutable;
+        setupContainment(pending.future.result(), pending.pluginName, pending.id, -1, false);
+        immutability = imm;
+    }
+
+    if (pendingContainments.isEmpty() && !importingLayout) {
+        notifyContainmentsReady();
+    }
+}
+
+void CoronaPrivate::finishPendingContainments()
+{
+    const QList<PendingContainment> pending = std::exchange(pendingContainments, {});
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    qCDebug(LOG_PLASMA) << "Loading" << pending.count() << "containments right away";
+
+    const Types::ImmutabilityType imm = immutability;
+    immutability = Types::Mutable;
+    for (PendingContainment entry : pending) {
+        Applet *applet = nullptr;
+        if (entry.future.isFinished()) {
+            applet = entry.future.result();
+        } else {
+            // the future finishes on this thread, canceling it here means it won't load anything anymore
+            entry.future.cancel();
+            if (entry.pluginName != QLatin1String("null")) {
+                applet = PluginLoader::self()->loadApplet(entry.pluginName, entry.id);
+            }
+        }
+        setupContainment(applet, entry.pluginName, entry.id, -1, false);
     }
+    immutability = imm;
+
+    if (!importingLayout) {
+        notifyContainmentsReady();
+    }
+}
 
-    bool loadingNull = pluginName == QLatin1String("null");
+Containment *CoronaPrivate::setupContainment(Applet *applet, const QString &pluginName, uint id, int lastScreen, bool delayedInit)
+{
+    Containment *containment = nullptr;
+
+    const bool loadingNull = pluginName == QLatin1String("null");
     if (!loadingNull) {
-        applet = PluginLoader::self()->loadApplet(pluginName, id, args);
         containment = dynamic_cast<Containment *>(applet);
         if (containment) {
             containment->setParent(q);
@@ -562,7 +1043,7 @@ Containment *CoronaPrivate::addContainment(const QString &name, const QVariantLi
     if (!containment) {
         if (!loadingNull) {
 #ifndef NDEBUG
-            // qCDebug(LOG_PLASMA) << "loading of containment" << name << "failed.";
+            // qCDebug(LOG_PLASMA) << "loading of containment" << pluginName << "failed.";
 #endif
         }
         // in case we got a non-Containment from Applet::loadApplet or
@@ -597,15 +1078,32 @@ Containment *CoronaPrivate::addContainment(const QString &name, const QVariantLi
         return c1->id() < c2->id();
     });
     containments.insert(position, containment);
+    indexContainment(containment);
 
     QObject::connect(containment, SIGNAL(destroyed(QObject *)), q, SLOT(containmentDestroyed(QObject *)));
     QObject::connect(containment, &Applet::configNeedsSaving, q, &Corona::requestConfigSync);
+    // keep the indexes up to date before anybody reacting to screenOwnerChanged queries them
+    auto reindex = [this, containment]() {
+        indexContainment(containment);
+    };
+    QObject::connect(containment, &Containment::screenChanged, q, reindex);
+    QObject::connect(containment, &Containment::activityChanged, q, reindex);
+    QObject::connect(containment, &Containment::locationChanged, q, reindex);
     QObject::connect(containment, &Containment::screenChanged, q, &Corona::screenOwnerChanged);
+    QObject::connect(containment, &Containment::uiReadyChanged, q, [containment](bool ready) {
+        AppletPrivate *p = containment->Applet::d;
+        if (ready && p->uiReadyAt < 0) {
+            p->uiReadyAt = Tracer::now();
+            Tracer::span("containmentUiReady", p->createdAt, containment->pluginName());
+        }
+    });
 
     if (!delayedInit) {
         containment->init();
+        containment->Applet::d->initializedAt = Tracer::now();
         KConfigGroup cg = containment->config();
         containment->restore(cg);
+        containment->Applet::d->restoredAt = Tracer::now();
         containment->updateConstraints(Applet::StartupCompletedConstraint);
         containment->save(cg);
         q->requestConfigSync();
@@ -632,63 +1130,345 @@ QList<Plasma::Containment *> CoronaPrivate::importLayout(const KConfigGroup &con
     for (Containment *containment : std::as_const(containments)) {
         containmentsIds.insert(containment->id());
     }
+    for (auto it = containmentPlaceholders.cbegin(); it != containmentPlaceholders.cend(); ++it) {
+        containmentsIds.insert(it.key());
+    }
 
-    KConfigGroup containmentsGroup(&conf, QStringLiteral("Containments"));
-    QStringList groups = containmentsGroup.groupList();
-    std::sort(groups.begin(), groups.end());
+    // merged layouts give back all of their containments, so those can't be deferred
+    const bool deferOtherActivities = lazyActivityLoading && !mergeConfig && !currentActivity.isEmpty();
 
-    for (const QString &group : std::as_const(groups)) {
-        KConfigGroup containmentConfig(&containmentsGroup, group);
+    KConfigGroup containmentsGroup(&conf, QStringLiteral("Containments"));
+    QList<LayoutSnapshot::Containment> layout;
+    // loadLayout has our own layout parsed already, out of its snapshot or its config
+    const bool fromSnapshot = !mergeConfig && layoutSnapshot;
+    if (fromSnapshot) {
+        layout = *std::exchange(layoutSnapshot, std::nullopt);
+    } else {
+        // merged containments restore their applets out of what gets read here
+        layout = LayoutSnapshot::read(conf, mergeConfig);
+    }
 
-        if (containmentConfig.entryMap().isEmpty()) {
-            continue;
-        } else if (containmentConfig.readEntry(QStringLiteral("transient"), false)) {
-            containmentConfig.deleteGroup();
+    // merged layouts have to give back the new containments right away
+    const bool async = asynchronousLoading && !mergeConfig;
+
+    // the ids the containments get, in the order of layout
+    QList<uint> ids;
+    ids.reserve(layout.count());
+    for (const LayoutSnapshot::Containment &entry : std::as_const(layout)) {
+        uint cid = entry.group.toUInt();
+        if (entry.transient) {
+            KConfigGroup(&containmentsGroup, entry.group).deleteGroup();
+            ids << cid;
             continue;
         }
 
-        uint cid = group.toUInt();
         if (containmentsIds.contains(cid)) {
             cid = ++AppletPrivate::s_maxAppletId;
         } else if (cid > AppletPrivate::s_maxAppletId) {
             AppletPrivate::s_maxAppletId = cid;
         }
+        containmentsIds.insert(cid);
+        ids << cid;
+    }
 
-        if (mergeConfig) {
-            KConfigGroup realConf(q->config(), QStringLiteral("Containments"));
-            realConf = KConfigGroup(&realConf, QString::number(cid));
+    // the merged containments get written all in one go, before creating them
+    // starts writing to the config as well
+    if (mergeConfig) {
+        KConfigGroup realContainments(q->config(), QStringLiteral("Containments"));
+        for (int i = 0; i < layout.count(); ++i) {
+            if (layout.at(i).transient) {
+                continue;
+            }
+            KConfigGroup realConf(&realContainments, QString::number(ids.at(i)));
             // in case something was there before us
-            realConf.deleteGroup();
-            containmentConfig.copyTo(&realConf);
+            if (realConf.exists()) {
+                realConf.deleteGroup();
+            }
+            KConfigGroup(&containmentsGroup, layout.at(i).group).copyTo(&realConf);
+        }
+    }
+
+    importingLayout = async;
+    mergingLayout = mergeConfig;
+
+    for (int i = 0; i < layout.count(); ++i) {
+        const LayoutSnapshot::Containment &entry = layout.at(i);
+        if (entry.transient) {
+            continue;
         }
+        const uint cid = ids.at(i);
+        KConfigGroup containmentConfig(&containmentsGroup, entry.group);
 
         // qCDebug(LOG_PLASMA) << "got a containment in the config, trying to make a" << containmentConfig.readEntry("plugin", QString()) << "from" << group;
 #ifndef NDEBUG
         // qCDebug(LOG_PLASMA) << "!!{} STARTUP TIME" << QTime().msecsTo(QTime::currentTime()) << "Adding Containment" << containmentConfig.readEntry("plugin",
         // QString());
 #endif
-        Containment *c = addContainment(containmentConfig.readEntry("plugin", QString()), QVariantList(), cid, -1);
+        if (deferOtherActivities && !entry.activity.isEmpty() && entry.activity != currentActivity) {
+            addContainmentPlaceholder(containmentConfig, cid);
+            continue;
+        }
+
+        if (fromSnapshot || mergeConfig) {
+            snapshotApplets.insert(cid, entry.applets);
+        }
+
+        if (async) {
+            addContainmentAsync(entry.pluginName, cid);
+            continue;
+        }
+
+        Containment *c = addContainment(entry.pluginName, QVariantList(), cid, -1);
         if (!c) {
             continue;
         }
 
         newContainments.append(c);
-        containmentsIds.insert(c->id());
 
 #ifndef NDEBUG
 //         qCDebug(LOG_PLASMA) << "!!{} STARTUP TIME" << QTime().msecsTo(QTime::currentTime()) << "Restored Containment" << c->pluginName();
 #endif
     }
 
-    if (!mergeConfig) {
+    importingLayout = false;
+    mergingLayout = false;
+
+    // with asynchronous loading processPendingContainments does it once the last containment is there
+    if (!mergeConfig && pendingContainments.isEmpty()) {
         notifyContainmentsReady();
     }
 
     return newContainments;
 }
 
+void CoronaPrivate::addContainmentPlaceholder(const KConfigGroup &containmentConfig, uint id)
+{
+    ContainmentPlaceholder placeholder;
+    placeholder.pluginName = containmentConfig.readEntry("plugin", QString());
+    placeholder.activity = containmentConfig.readEntry("activityId", QString());
+    placeholder.lastScreen = containmentConfig.readEntry("lastScreen", -1);
+    containmentPlaceholders.insert(id, placeholder);
+
+    // applets created meanwhile must not take the ids of the ones still in the config
+    const QStringList appletGroups = KConfigGroup(&containmentConfig, QStringLiteral("Applets")).groupList();
+    for (const QString &appletGroup : appletGroups) {
+        AppletPrivate::s_maxAppletId = std::max(AppletPrivate::s_maxAppletId, appletGroup.toUInt());
+    }
+}
+
+void CoronaPrivate::materializeContainments(const std::function<bool(const QString &activity, int lastScreen)> &filter)
+{
+    QList<uint> ids;
+    for (auto it = containmentPlaceholders.cbegin(); it != containmentPlaceholders.cend(); ++it) {
+        if (filter(it->activity, it->lastScreen)) {
+            ids << it.key();
+        }
+    }
+
+    for (uint id : std::as_const(ids)) {
+        const ContainmentPlaceholder placeholder = containmentPlaceholders.take(id);
+        qCDebug(LOG_PLASMA) << "Creating containment" << id << placeholder.pluginName << "of activity" << placeholder.activity;
+        addContainment(placeholder.pluginName, QVariantList(), id, -1);
+    }
+}
+
+void CoronaPrivate::hibernateContainments()
+{
+    if (!lazyActivityLoading || currentActivity.isEmpty()) {
+        return;
+    }
+
+    const QList<Containment *> candidates = containments;
+    for (Containment *containment : candidates) {
+        const QString activity = containment->activity();
+        // anything still on a screen has views pointing to it
+        if (activity.isEmpty() || activity == currentActivity || containment->screen() >= 0 || containment->pluginName().isEmpty()) {
+            continue;
+        }
+
+        KConfigGroup cg = containment->config();
+        containment->save(cg);
+
+        ContainmentPlaceholder placeholder;
+        placeholder.pluginName = containment->pluginName();
+        placeholder.activity = activity;
+        placeholder.lastScreen = containment->lastScreen();
+        const uint id = containment->id();
+
+        qCDebug(LOG_PLASMA) << "Hibernating containment" << id << placeholder.pluginName << "of activity" << activity;
+        delete containment;
+        containmentPlaceholders.insert(id, placeholder);
+    }
+}
+
+void CoronaPrivate::prefetchLayoutPlugins(const KConfigGroup &conf) const
+{
+    QStringList plugins;
+
+    // loadLayout has the layout parsed already, importLayout picks it up from there
+    const QList<LayoutSnapshot::Containment> layout = layoutSnapshot.value_or(QList<LayoutSnapshot::Containment>());
+    for (const LayoutSnapshot::Containment &containment : layout) {
+        const QString plugin = containmentPluginName(containment.pluginName);
+        if (plugin != QLatin1String("null")) {
+            plugins << plugin;
+        }
+
+        for (const LayoutSnapshot::Applet &applet : containment.applets) {
+            if (!applet.pluginName.isEmpty()) {
+                plugins << applet.pluginName;
+            }
+        }
+    }
+
+    plugins.removeDuplicates();
+    PluginLoader::self()->prefetchApplets(plugins);
+
+    // the first right click or scroll on the desktop should not have to wait for a dlopen
+    static const QStringList defaultTriggers = {QStringLiteral("RightButton;NoModifier"), QStringLiteral("wheel:Vertical;NoModifier")};
+    QList<KConfigGroup> actionGroups;
+    const KConfigGroup actionPlugins(&conf, QStringLiteral("ActionPlugins"));
+    const QStringList actionPluginGroups = actionPlugins.groupList();
+    for (const QString &group : actionPluginGroups) {
+        actionGroups << KConfigGroup(&actionPlugins, group);
+    }
+    if (package.isValid()) {
+        const KSharedConfigPtr defaults = KSharedConfig::openConfig(package.filePath("defaults"));
+        for (const QString &group : {QStringLiteral("Desktop"), QStringLiteral("Panel")}) {
+            actionGroups << KConfigGroup(defaults, group).group(QStringLiteral("ContainmentActions"));
+        }
+    }
+
+    QStringList actions;
+    for (const KConfigGroup &group : std::as_const(actionGroups)) {
+        for (const QString &trigger : defaultTriggers) {
+            const QString plugin = group.readEntry(trigger, QString());
+            if (!plugin.isEmpty()) {
+                actions << plugin;
+            }
+        }
+    }
+    actions.removeDuplicates();
+    PluginLoader::self()->preloadContainmentActions(actions);
+}
+
+bool CoronaPrivate::takeSnapshotApplets(Containment *containment, const KConfigGroup &group, QList<LayoutSnapshot::Applet> *applets)
+{
+    // only what restores the containment out of its own group in our own config is in the snapshot
+    if (group.config() != q->config().data() || group.name() != QString::number(containment->id())) {
+        return false;
+    }
+    const auto it = snapshotApplets.constFind(containment->id());
+    if (it == snapshotApplets.cend()) {
+        return false;
+    }
+    *applets = it.value();
+    snapshotApplets.erase(it);
+    return true;
+}
+
+void CoronaPrivate::scheduleConstraintsFlush(Applet *applet)
+{
+    ++constraintsStatistics.requests;
+    if (applet->d->constraintsQueued) {
+        ++constraintsStatistics.coalesced;
+        return;
+    }
+
+    applet->d->constraintsQueued = true;
+    pendingConstraintsApplets << applet;
+    if (!constraintsTimer->isActive()) {
+        constraintsTimer->start();
+    }
+}
+
+void CoronaPrivate::flushPendingConstraints()
+{
+    const quint64 flushes = constraintsStatistics.flushes;
+
+    // what a flush passes on, like the immutability of a containment to its
+    // applets, gets queued and is flushed in this same pass
+    while (!pendingConstraintsApplets.isEmpty()) {
+        QList<QPointer<Applet>> batch = std::exchange(pendingConstraintsApplets, {});
+        batch.removeIf([](const QPointer<Applet> &applet) {
+            return !applet;
+        });
+        // containments before applets, then by id, no matter who asked first
+        std::sort(batch.begin(), batch.end(), [](const QPointer<Applet> &a1, const QPointer<Applet> &a2) {
+            const bool c1 = a1->isContainment();
+            const bool c2 = a2->isContainment();
+            return c1 != c2 ? c1 : a1->id() < a2->id();
+        });
+
+        for (const QPointer<Applet> &applet : std::as_const(batch)) {
+            // an earlier flush of this pass may have deleted it
+            if (!applet) {
+                continue;
+            }
+            applet->d->constraintsQueued = false;
+
+            // Don't flushPendingConstraints if we're just starting up
+            // flushPendingConstraints will be called by Corona
+            if (applet->d->transient || (applet->d->pendingConstraints & Applet::StartupCompletedConstraint)) {
+                continue;
+            }
+            // it may have flushed on its own meanwhile, then there is nothing to send
+            if (applet->d->pendingConstraints == Applet::NoConstraint) {
+                continue;
+            }
+            applet->flushPendingConstraintsEvents();
+            ++constraintsStatistics.flushes;
+        }
+    }
+
+    if (constraintsStatistics.flushes != flushes) {
+        ++constraintsStatistics.passes;
+    }
+}
+
+void CoronaPrivate::scheduleDeferredApplet(Containment *containment, const PluginLoader::AppletSpec &spec, int priority, bool onPanel)
+{
+    const DeferredApplet deferred{containment, containment->id(), spec, priority, onPanel};
+    auto position = std::upper_bound(deferredApplets.begin(), deferredApplets.end(), deferred, [](const DeferredApplet &a1, const DeferredApplet &a2) {
+        if (a1.priority != a2.priority) {
+            return a1.priority > a2.priority;
+        }
+        if (a1.onPanel != a2.onPanel) {
+            return a1.onPanel;
+        }
+        if (a1.containmentId != a2.containmentId) {
+            return a1.containmentId < a2.containmentId;
+        }
+        return a1.spec.appletId < a2.spec.appletId;
+    });
+    deferredApplets.insert(position, deferred);
+
+    if (!deferredAppletsTimer->isActive()) {
+        deferredAppletsTimer->start();
+    }
+}
+
+void CoronaPrivate::restoreDeferredApplet()
+{
+    if (deferredApplets.isEmpty()) {
+        return;
+    }
+
+    // one at a time, so that whatever else is going on gets its turn in between
+    const DeferredApplet deferred = deferredApplets.takeFirst();
+    if (deferred.containment) {
+        Tracer::Scope trace("restoreDeferredApplet", deferred.spec.name);
+        deferred.containment->d->restoreDeferredApplet(deferred.spec);
+    }
+
+    if (!deferredApplets.isEmpty()) {
+        deferredAppletsTimer->start();
+    }
+}
+
 void CoronaPrivate::notifyContainmentsReady()
 {
+    // anything left was not restored right now, its config may change before it is
+    snapshotApplets.clear();
     containmentsStarting = 0;
     for (Containment *containment : std::as_const(containments)) {
         if (!containment->isUiReady() && containment->screen() >= 0) {
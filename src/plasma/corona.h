@@ -13,6 +13,7 @@
 #include <plasma/plasma.h>
 #include <plasma/plasma_export.h>
 
+class QAbstractItemModel;
 class QAction;
 
 namespace Plasma
@@ -31,6 +32,14 @@ class PLASMA_EXPORT Corona : public QObject
     Q_PROPERTY(bool editMode READ isEditMode WRITE setEditMode NOTIFY editModeChanged)
     Q_PROPERTY(KPackage::Package kPackage READ kPackage NOTIFY kPackageChanged)
 
+    Q_MOC_INCLUDE(<QAbstractItemModel>)
+    /**
+     * The loadingTimes() of all containments and applets, slowest first.
+     * The roles are named like the LoadingTimes fields.
+     * @since 6.0
+     */
+    Q_PROPERTY(QAbstractItemModel *loadingTimesModel READ loadingTimesModel CONSTANT)
+
 public:
     explicit Corona(QObject *parent = nullptr);
     ~Corona() override;
@@ -55,6 +64,10 @@ public:
 
     /**
      * @return all containments on this Corona
+     *
+     * With lazy activity loading, the containments of other activities
+     * that were not needed yet are not listed.
+     * @see setLazyActivityLoadingEnabled
      */
     QList<Containment *> containments() const;
 
@@ -209,6 +222,17 @@ public:
      */
     virtual int screenForContainment(const Containment *containment) const;
 
+    /**
+     * Tells whether @p containment is known not to be shown on any screen.
+     * The applets of such containments get restored after all the others
+     * at startup.
+     *
+     * The default implementation returns false: unless reimplemented,
+     * every containment is restored as if it was on screen.
+     * @since 6.0
+     */
+    virtual bool isContainmentOffScreen(const Containment *containment) const;
+
     /**
      * @return The type of immutability of this Corona
      */
@@ -229,6 +253,232 @@ public:
      */
     bool isEditMode() const;
 
+    /**
+     * Sets whether loadLayout() loads containments and applets asynchronously.
+     *
+     * When enabled, plugins are looked up and loaded on worker threads via
+     * PluginLoader::loadAppletAsync and the event loop keeps running while the
+     * layout gets restored. Containments and applets are still created and added
+     * in the same order as with synchronous loading, and startupCompleted() is
+     * emitted only once all of them have been restored.
+     *
+     * Disabled by default; it has to be set before calling loadLayout().
+     * @since 6.0
+     */
+    void setAsynchronousLoadingEnabled(bool enabled);
+
+    /**
+     * @returns true if loadLayout() loads containments and applets asynchronously
+     * @since 6.0
+     */
+    bool isAsynchronousLoadingEnabled() const;
+
+    /**
+     * Sets whether configuration syncs write to disk from a separate thread.
+     *
+     * When enabled, syncing takes a copy of the configuration on the main
+     * thread and leaves serializing and writing it to a writer thread;
+     * configSynced() is emitted once the write landed. Syncs requested while
+     * a write is in progress are coalesced into a single write right after it.
+     *
+     * Disabled by default.
+     * @since 6.0
+     */
+    void setAsynchronousConfigSyncEnabled(bool enabled);
+
+    /**
+     * @returns true if configuration syncs write to disk from a separate thread
+     * @since 6.0
+     */
+    bool isAsynchronousConfigSyncEnabled() const;
+
+    /**
+     * Decides when a sync asked for with requestConfigSync() actually happens.
+     *
+     * Requests coming in a burst are coalesced: the sync happens once no new
+     * request came for the idle interval, but never later than the maximum
+     * interval after the first unsynced request, which bounds how much gets
+     * lost on a crash.
+     *
+     * @since 6.0
+     */
+    struct ConfigSyncPolicy {
+        /**
+         * sync once no other sync got requested for this many milliseconds;
+         * requests are what is counted, not user input
+         */
+        int idleInterval = 2000;
+        /** idle interval in edit mode, where dragging and resizing keep requesting syncs */
+        int editModeIdleInterval = 5000;
+        /** never leave a requested sync pending for longer than this many milliseconds */
+        int maximumInterval = 10000;
+    };
+
+    /**
+     * Sets the policy deciding when requested config syncs happen.
+     * @since 6.0
+     */
+    void setConfigSyncPolicy(const ConfigSyncPolicy &policy);
+
+    /**
+     * @returns the policy deciding when requested config syncs happen
+     * @since 6.0
+     */
+    ConfigSyncPolicy configSyncPolicy() const;
+
+    /**
+     * Counters of the config syncs, meant for diagnostics.
+     *
+     * @since 6.0
+     */
+    struct ConfigSyncStatistics {
+        /** syncs done since the Corona got created */
+        quint64 syncs = 0;
+        /** syncs done in the last 60 seconds */
+        int syncsLastMinute = 0;
+        /**
+         * size the config file had after each sync, summed over all of them.
+         * Not what got written to disk, which KConfig does not tell
+         */
+        quint64 fileBytes = 0;
+        /** milliseconds the last sync took until its write landed, -1 if none happened yet */
+        qint64 lastLatency = -1;
+        /** the longest any sync took, in milliseconds */
+        qint64 maximumLatency = 0;
+    };
+
+    /**
+     * @return the counters of the config syncs done by this Corona
+     * @since 6.0
+     */
+    ConfigSyncStatistics configSyncStatistics() const;
+
+    /**
+     * Counters of the constraint updates of the applets, which get flushed
+     * all together once the event loop runs instead of one applet at a time
+     *
+     * @since 6.0
+     */
+    struct ConstraintsStatistics {
+        /** constraint updates asked for by the applets */
+        quint64 requests = 0;
+        /** requests merged into a flush already pending for the same applet */
+        quint64 coalesced = 0;
+        /** times an applet got its pending constraints flushed */
+        quint64 flushes = 0;
+        /** event loop passes that flushed constraints */
+        quint64 passes = 0;
+    };
+
+    /**
+     * @return the counters of the constraint updates of the applets of this Corona
+     * @since 6.0
+     */
+    ConstraintsStatistics constraintsStatistics() const;
+
+    /**
+     * Defers creating the containments of the activities the user is not on.
+     *
+     * When enabled, loading a layout only takes note of the containments
+     * belonging to an activity other than currentActivity(), without creating
+     * them or their applets. They get created the first time
+     * containmentForScreen(), containmentsForScreen() or containmentsForActivity()
+     * need them, or when their activity becomes the current one.
+     *
+     * Both this and the current activity have to be set before loading the layout.
+     *
+     * @see setContainmentHibernationTimeout
+     * @since 6.0
+     */
+    void setLazyActivityLoadingEnabled(bool enabled);
+
+    /**
+     * @return true if the containments of other activities are created only when needed
+     * @since 6.0
+     */
+    bool isLazyActivityLoadingEnabled() const;
+
+    /**
+     * Tells the Corona which activity the user is on. With lazy activity
+     * loading, switching to an activity creates all of its containments.
+     *
+     * @since 6.0
+     */
+    void setCurrentActivity(const QString &activity);
+
+    /**
+     * @return the activity the user is on, as set with setCurrentActivity()
+     * @since 6.0
+     */
+    QString currentActivity() const;
+
+    /**
+     * With lazy activity loading, once the current activity did not change
+     * for @p msec milliseconds, the containments of the other activities that
+     * are not on any screen get saved and deleted, to be created again when
+     * needed. 0, the default, keeps them around.
+     *
+     * @since 6.0
+     */
+    void setContainmentHibernationTimeout(int msec);
+
+    /**
+     * @return after how many milliseconds the containments of other activities are hibernated,
+     *         0 if they never are
+     * @since 6.0
+     */
+    int containmentHibernationTimeout() const;
+
+    /**
+     * Writes what got traced in this process so far, like loading plugins,
+     * packages and QML, applets and containments getting ready and the startup
+     * completing, to @p fileName in the Chrome trace event format, which
+     * chrome://tracing and https://ui.perfetto.dev can open.
+     *
+     * @return true if the file got written
+     * @since 6.0
+     */
+    static bool exportTrace(const QString &fileName);
+
+    /**
+     * When a containment or applet went through the steps of getting loaded,
+     * in milliseconds since the Corona got created, -1 for the steps it did
+     * not go through (yet).
+     *
+     * @since 6.0
+     */
+    struct LoadingTimes {
+        uint id = 0;
+        /** the containment of the applet, the id itself for containments */
+        uint containmentId = 0;
+        QString pluginName;
+        bool isContainment = false;
+        qint64 created = -1;
+        qint64 initialized = -1;
+        qint64 restored = -1;
+        /** its QML got loaded */
+        qint64 qmlLoaded = -1;
+        /** it got the Applet::UiReadyConstraint */
+        qint64 uiReadyConstraint = -1;
+        /** it became ready, for containments once all of their applets were ready as well */
+        qint64 uiReady = -1;
+        /** from created to uiReady, or until now if not ready yet */
+        qint64 duration = -1;
+    };
+
+    /**
+     * @return the loading times of all containments and their applets, slowest
+     *         first, to tell what held back the startup
+     * @since 6.0
+     */
+    QList<LoadingTimes> loadingTimes() const;
+
+    /**
+     * @return a model of loadingTimes(), for QML
+     * @since 6.0
+     */
+    QAbstractItemModel *loadingTimesModel() const;
+
     // TODO: make them not slots anymore
 public Q_SLOTS:
     /**
@@ -295,6 +545,7 @@ Q_SIGNALS:
 
     /**
      * This signal indicates that the configuration file was flushed to disk.
+     * With asynchronous config sync it is emitted once the write landed.
      */
     void configSynced();
 
@@ -386,6 +637,8 @@ private:
     Q_PRIVATE_SLOT(d, void containmentReady(bool))
 
     friend class CoronaPrivate;
+    friend class AppletPrivate;
+    friend class Containment;
     friend class View;
 };
 
@@ -6,18 +6,32 @@
 
 #include "pluginloader.h"
 
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QGuiApplication>
+#include <QMimeDatabase>
+#include <QMutex>
 #include <QPluginLoader>
 #include <QPointer>
+#include <QPromise>
+#include <QSemaphore>
+#include <QSet>
 #include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
 
 #include <KLazyLocalizedString>
 #include <KRuntimePlatform>
 #include <QDebug>
-#include <QRegularExpression>
 #include <kcoreaddons_export.h>
 #include <kpackage/packageloader.h>
 
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <vector>
+
 #include "config-plasma.h"
 
 #include "applet.h"
@@ -25,6 +39,9 @@
 #include "containmentactions.h"
 #include "debug_p.h"
 #include "private/applet_p.h"
+#include "private/appletindex_p.h"
+#include "private/packageregistry_p.h"
+#include "private/tracer_p.h"
 
 namespace Plasma
 {
@@ -38,28 +55,102 @@ class PluginLoaderPrivate
 public:
     PluginLoaderPrivate()
     {
+        if (QCoreApplication *app = QCoreApplication::instance()) {
+            mainThreadContext.moveToThread(app->thread());
+        }
+        // nobody waits for prefetching, it must not take the disk or the cpu away from what does
+        prefetchPool.setMaxThreadCount(2);
+        prefetchPool.setThreadPriority(QThread::LowPriority);
+    }
+
+    ~PluginLoaderPrivate()
+    {
+        prefetchPool.clear();
+        prefetchPool.waitForDone();
+        threadPool.waitForDone();
     }
 
+    // the form factors applets get listed for, empty for all of them
+    const QStringList &runtimePlatforms();
+
+    struct ResolvedApplet {
+        KPluginMetaData plugin;
+        KPackage::Package package;
+        // the translations of the package got registered already
+        bool translationsAdded = false;
+    };
+    ResolvedApplet resolveApplet(const QString &name);
+    Applet *instantiateApplet(const QString &name, uint appletId, const QVariantList &args, const ResolvedApplet &resolved);
+
+    // these run on any thread
+    // like resolveApplet, with a package of its own to share with PackageRegistry::insert on the main thread
+    ResolvedApplet lookUpApplet(const QString &name);
+    static void addTranslations(const QString &name, const KPackage::Package &package);
+    static void preloadLibrary(const QString &fileName);
+    static void preloadPackageFiles(const QString &packageDir);
+
     static QString s_plasmoidsPluginDir;
     static QString s_containmentActionsPluginDir;
 
     class Cache
     {
-        // We only use this cache during start of the process to speed up many consecutive calls
-        // After that, we're too afraid to produce race conditions and it's not that time-critical anyway
-        // the 20 seconds here means that the cache is only used within 20sec during startup, after that,
-        // complexity goes up and we'd have to update the cache in order to avoid subtle bugs
-        // just not using the cache is way easier then, since it doesn't make *that* much of a difference,
-        // anyway
-        int maxCacheAge = 20;
-        qint64 pluginCacheAge = 0;
-        QHash<QString, KPluginMetaData> plugins;
-
+        // The cache is kept for the whole lifetime of the process, what keeps it
+        // correct is watching the plugin directories, their parents until they
+        // exist and the files of the loaded plugins: whenever a plugin gets
+        // installed, updated or removed the whole hash is thrown away and refilled
+        // on the next lookup
     public:
-        KPluginMetaData findPluginById(const QString &name, const QString &pluginNamespace);
+        explicit Cache(const QString &pluginNamespace);
+        ~Cache();
+
+        KPluginMetaData findPluginById(const QString &name);
+        // plugins having X-KDE-ParentApp set to parentApp, all of them if it's empty
+        QList<KPluginMetaData> pluginsForParentApp(const QString &parentApp);
+        PluginLoader::PluginCacheStatistics statistics() const;
+        // has to be called from the main thread, lets other threads populate the cache
+        void watchPluginDirectories();
+        // has to be called from the main thread, once the library of plugin got loaded
+        void watchPluginFile(const KPluginMetaData &plugin);
+        // factories kept loaded, they get dropped together with the rest of the cache.
+        // factory() is for creating plugins and counts in the statistics, hasFactory() doesn't
+        KPluginFactory *factory(const QString &pluginId);
+        bool hasFactory(const QString &pluginId) const;
+        void insertFactory(const QString &pluginId, KPluginFactory *factory);
+
+    private:
+        void invalidate();
+        // these expect mutex to be locked
+        bool ensurePopulated();
+        bool populate();
+        void createWatcher();
+        void updateWatchedDirectories();
+
+        const QString pluginNamespace;
+        mutable QMutex mutex;
+        QHash<QString, KPluginMetaData> plugins;
+        // plugins with metadata in the order findPlugins gives them, and the same by X-KDE-ParentApp
+        QList<KPluginMetaData> listedPlugins;
+        QHash<QString, QList<KPluginMetaData>> pluginsByParentApp;
+        QPointer<QFileSystemWatcher> watcher;
+        // the plugin directories, or their closest existing parent for the ones not there yet
+        QStringList watchedDirectories;
+        QSet<QString> watchedFiles;
+        QHash<QString, KPluginFactory *> factories;
+        bool populated = false;
+        PluginLoader::PluginCacheStatistics stats;
     };
-    Cache plasmoidCache;
-    Cache containmentactionCache;
+    Cache plasmoidCache{s_plasmoidsPluginDir};
+    // keeps the factories loaded by PluginLoader::preloadContainmentActions
+    Cache containmentactionCache{s_containmentActionsPluginDir};
+    AppletIndex appletIndex;
+    // for the work somebody is waiting the result of
+    QThreadPool threadPool;
+    // for prefetchApplets
+    QThreadPool prefetchPool;
+    // what the workers queue their results back to the main thread with, so that
+    // nothing pending gets run once the loader is gone
+    QObject mainThreadContext;
+    std::optional<QStringList> platforms;
 };
 
 QString PluginLoaderPrivate::s_plasmoidsPluginDir = QStringLiteral("plasma/applets");
@@ -87,31 +178,221 @@ Applet *PluginLoader::loadApplet(const QString &name, uint appletId, const QVari
         return nullptr;
     }
 
-    Applet *applet = nullptr;
-
     if (appletId == 0) {
         appletId = ++AppletPrivate::s_maxAppletId;
     }
 
-    auto plugin = d->plasmoidCache.findPluginById(name, PluginLoaderPrivate::s_plasmoidsPluginDir);
-    const KPackage::Package p = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Plasma/Applet"), name);
+    const PluginLoaderPrivate::ResolvedApplet resolved = d->resolveApplet(name);
+    return d->instantiateApplet(name, appletId, args, resolved);
+}
 
-    if (!p.isValid()) {
+QList<Applet *> PluginLoader::loadApplets(const QList<AppletSpec> &specs)
+{
+    // ids are given in order, as with sequential loadApplet calls
+    QList<uint> appletIds;
+    appletIds.reserve(specs.count());
+    for (const AppletSpec &spec : specs) {
+        appletIds << (spec.appletId == 0 && !spec.name.isEmpty() ? ++AppletPrivate::s_maxAppletId : spec.appletId);
+    }
+
+    // panels tend to have the same applet many times, resolve each only once
+    QHash<QString, PluginLoaderPrivate::ResolvedApplet> resolved;
+    QStringList lookUps;
+    for (const AppletSpec &spec : specs) {
+        if (spec.name.isEmpty() || resolved.contains(spec.name) || lookUps.contains(spec.name)) {
+            continue;
+        }
+        if (PackageRegistry::self()->cachedPackage(spec.name).isValid()) {
+            resolved.insert(spec.name, d->resolveApplet(spec.name));
+        } else {
+            lookUps << spec.name;
+        }
+    }
+
+    if (!lookUps.isEmpty()) {
+        d->plasmoidCache.watchPluginDirectories();
+
+        // the packages not shared yet get looked up in parallel. The main thread
+        // takes its share as well, so that it only waits for what the workers
+        // already started: workers the pool gets to only later find nothing left
+        struct LookUps {
+            QStringList names;
+            std::vector<PluginLoaderPrivate::ResolvedApplet> results;
+            std::atomic<int> next{0};
+            QSemaphore done;
+        };
+        auto batch = std::make_shared<LookUps>();
+        batch->names = lookUps;
+        batch->results.resize(lookUps.count());
+
+        PluginLoaderPrivate *loader = d;
+        auto lookUpNext = [loader](LookUps *state) {
+            for (int i = state->next++; i < state->names.count(); i = state->next++) {
+                state->results[i] = loader->lookUpApplet(state->names.at(i));
+                state->done.release();
+            }
+        };
+        const int workers = std::min<int>(lookUps.count() - 1, d->threadPool.maxThreadCount());
+        for (int i = 0; i < workers; ++i) {
+            d->threadPool.start([batch, lookUpNext]() {
+                lookUpNext(batch.get());
+            });
+        }
+        lookUpNext(batch.get());
+        batch->done.acquire(lookUps.count());
+
+        for (int i = 0; i < lookUps.count(); ++i) {
+            PluginLoaderPrivate::ResolvedApplet result = batch->results[i];
+            result.package = PackageRegistry::self()->insert(lookUps.at(i), QString(), result.package);
+            resolved.insert(lookUps.at(i), result);
+        }
+    }
+
+    // the libraries get dlopen'd right here as the applets get created: the dynamic
+    // loader serializes dlopen anyways
+    QList<Applet *> applets;
+    applets.reserve(specs.count());
+    for (int i = 0; i < specs.count(); ++i) {
+        const AppletSpec &spec = specs.at(i);
+        applets << (spec.name.isEmpty() ? nullptr : d->instantiateApplet(spec.name, appletIds.at(i), spec.args, resolved.value(spec.name)));
+    }
+    return applets;
+}
+
+QHash<QString, int> PluginLoader::appletStartupPriorities(const QStringList &names)
+{
+    QHash<QString, int> priorities;
+    if (names.isEmpty()) {
+        return priorities;
+    }
+
+    const QSet<QString> ids(names.begin(), names.end());
+    const QList<KPluginMetaData> packages = d->appletIndex.metaData([&ids](const AppletIndex::Entry &entry) {
+        return ids.contains(entry.pluginId);
+    });
+    for (const KPluginMetaData &package : packages) {
+        if (package.rawData().contains(QStringLiteral("X-Plasma-StartupPriority"))) {
+            priorities.insert(package.pluginId(), package.value(QStringLiteral("X-Plasma-StartupPriority"), 0));
+        }
+    }
+    return priorities;
+}
+
+void PluginLoader::prefetchApplets(const QStringList &names)
+{
+    if (names.isEmpty()) {
+        return;
+    }
+
+    // everything touching the plugin cache and the package index is resolved
+    // here, the workers only get paths
+    const QSet<QString> ids(names.begin(), names.end());
+    const QList<KPluginMetaData> packages = d->appletIndex.metaData([&ids](const AppletIndex::Entry &entry) {
+        return ids.contains(entry.pluginId);
+    });
+
+    QSet<QString> libraries;
+    QStringList packageDirs;
+    for (const QString &name : ids) {
+        const KPluginMetaData plugin = d->plasmoidCache.findPluginById(name);
+        if (plugin.isValid() && !plugin.isStaticPlugin()) {
+            libraries.insert(plugin.fileName());
+        }
+    }
+    for (const KPluginMetaData &package : packages) {
+        packageDirs << QFileInfo(package.fileName()).path();
+        const QString parentPlugin = package.value(QStringLiteral("X-Plasma-RootPath"));
+        if (!parentPlugin.isEmpty()) {
+            const KPluginMetaData plugin = d->plasmoidCache.findPluginById(parentPlugin);
+            if (plugin.isValid() && !plugin.isStaticPlugin()) {
+                libraries.insert(plugin.fileName());
+            }
+        }
+    }
+
+    qCDebug(LOG_PLASMA) << "Prefetching" << libraries.count() << "plugins and" << packageDirs.count() << "packages";
+
+    for (const QString &library : std::as_const(libraries)) {
+        d->prefetchPool.start([library]() {
+            PluginLoaderPrivate::preloadLibrary(library);
+        });
+    }
+    for (const QString &packageDir : std::as_const(packageDirs)) {
+        d->prefetchPool.start([packageDir]() {
+            PluginLoaderPrivate::preloadPackageFiles(packageDir);
+        });
+    }
+}
+
+PluginLoaderPrivate::ResolvedApplet PluginLoaderPrivate::resolveApplet(const QString &name)
+{
+    const KPackage::Package package = PackageRegistry::self()->cachedPackage(name);
+    if (!package.isValid()) {
+        ResolvedApplet resolved = lookUpApplet(name);
+        resolved.package = PackageRegistry::self()->insert(name, QString(), resolved.package);
+        return resolved;
+    }
+
+    ResolvedApplet resolved;
+    resolved.plugin = plasmoidCache.findPluginById(name);
+    resolved.package = package;
+    // If the applet is using another applet package, search for the plugin of the other applet
+    if (!resolved.plugin.isValid()) {
+        const QString parentPlugin = resolved.package.metadata().value(QStringLiteral("X-Plasma-RootPath"));
+        if (!parentPlugin.isEmpty()) {
+            resolved.plugin = plasmoidCache.findPluginById(parentPlugin);
+        }
+    }
+    return resolved;
+}
+
+PluginLoaderPrivate::ResolvedApplet PluginLoaderPrivate::lookUpApplet(const QString &name)
+{
+    ResolvedApplet resolved;
+    resolved.plugin = plasmoidCache.findPluginById(name);
+    resolved.package = PackageRegistry::loadPackage(name);
+
+    if (!resolved.package.isValid()) {
         qWarning(LOG_PLASMA) << "Applet invalid: Cannot find a package for" << name;
     }
 
     // If the applet is using another applet package, search for the plugin of the other applet
-    if (!plugin.isValid()) {
-        const QString parentPlugin = p.metadata().value(QStringLiteral("X-Plasma-RootPath"));
+    if (!resolved.plugin.isValid()) {
+        const QString parentPlugin = resolved.package.metadata().value(QStringLiteral("X-Plasma-RootPath"));
         if (!parentPlugin.isEmpty()) {
-            plugin = d->plasmoidCache.findPluginById(parentPlugin, PluginLoaderPrivate::s_plasmoidsPluginDir);
+            resolved.plugin = plasmoidCache.findPluginById(parentPlugin);
         }
     }
 
+    // without a plugin the applet is made out of the package only, which brings its translations
+    if (!resolved.plugin.isValid()) {
+        addTranslations(name, resolved.package);
+        resolved.translationsAdded = true;
+    }
+
+    return resolved;
+}
+
+void PluginLoaderPrivate::addTranslations(const QString &name, const KPackage::Package &package)
+{
+    const QString localePath = package.filePath("translations");
+    if (!localePath.isEmpty()) {
+        KLocalizedString::addDomainLocaleDir(QByteArray("plasma_applet_") + name.toLatin1(), localePath);
+    }
+}
+
+Applet *PluginLoaderPrivate::instantiateApplet(const QString &name, uint appletId, const QVariantList &args, const ResolvedApplet &resolved)
+{
+    Tracer::Scope trace("loadApplet", name);
+    const KPackage::Package &p = resolved.package;
+    const KPluginMetaData &plugin = resolved.plugin;
+    Applet *applet = nullptr;
+
     if (plugin.isValid()) {
         QPluginLoader loader(plugin.fileName());
         QVariantList allArgs = QVariantList{QVariant::fromValue(p), appletId} << args;
         if (KPluginFactory *factory = KPluginFactory::loadFactory(plugin).plugin) {
+            plasmoidCache.watchPluginFile(plugin);
             if (factory->metaData().rawData().isEmpty()) {
                 factory->setMetaData(p.metadata());
             }
@@ -131,23 +412,69 @@ Applet *PluginLoader::loadApplet(const QString &name, uint appletId, const QVari
         applet = new Applet(nullptr, p.metadata(), allArgs);
     }
 
-    const QString localePath = p.filePath("translations");
-    if (!localePath.isEmpty()) {
-        KLocalizedString::addDomainLocaleDir(QByteArray("plasma_applet_") + name.toLatin1(), localePath);
+    if (!resolved.translationsAdded) {
+        addTranslations(name, p);
     }
     return applet;
 }
 
+QFuture<Applet *> PluginLoader::loadAppletAsync(const QString &name, uint appletId, const QVariantList &args)
+{
+    auto promise = std::make_shared<QPromise<Applet *>>();
+    QFuture<Applet *> future = promise->future();
+    promise->start();
+
+    if (name.isEmpty()) {
+        promise->addResult(nullptr);
+        promise->finish();
+        return future;
+    }
+
+    if (appletId == 0) {
+        appletId = ++AppletPrivate::s_maxAppletId;
+    }
+
+    d->plasmoidCache.watchPluginDirectories();
+
+    // the pool is waited for when the loader goes away, and a promise dropped
+    // with the queued call gets canceled
+    PluginLoaderPrivate *loader = d;
+    d->threadPool.start([loader, name, appletId, args, promise]() {
+        PluginLoaderPrivate::ResolvedApplet resolved = loader->lookUpApplet(name);
+        if (resolved.plugin.isValid() && !resolved.plugin.isStaticPlugin()) {
+            PluginLoaderPrivate::preloadLibrary(resolved.plugin.fileName());
+        }
+
+        QMetaObject::invokeMethod(
+            &loader->mainThreadContext,
+            [loader, name, appletId, args, promise, resolved]() mutable {
+                if (!promise->isCanceled()) {
+                    // some other applet of the same plugin may have shared its package meanwhile
+                    resolved.package = PackageRegistry::self()->insert(name, QString(), resolved.package);
+                    promise->addResult(loader->instantiateApplet(name, appletId, args, resolved));
+                }
+                promise->finish();
+            },
+            Qt::QueuedConnection);
+    });
+
+    return future;
+}
+
 ContainmentActions *PluginLoader::loadContainmentActions(Containment *parent, const QString &name, const QVariantList &args)
 {
     if (name.isEmpty()) {
         return nullptr;
     }
 
-    KPluginMetaData plugin = d->containmentactionCache.findPluginById(name, PluginLoaderPrivate::s_containmentActionsPluginDir);
+    KPluginMetaData plugin = d->containmentactionCache.findPluginById(name);
 
     if (plugin.isValid()) {
+        if (KPluginFactory *factory = d->containmentactionCache.factory(plugin.pluginId())) {
+            return factory->create<Plasma::ContainmentActions>(nullptr, {QVariant::fromValue(plugin)});
+        }
         if (auto res = KPluginFactory::instantiatePlugin<Plasma::ContainmentActions>(plugin, nullptr, {QVariant::fromValue(plugin)})) {
+            d->containmentactionCache.watchPluginFile(plugin);
             return res.plugin;
         }
     }
@@ -155,163 +482,369 @@ ContainmentActions *PluginLoader::loadContainmentActions(Containment *parent, co
     return nullptr;
 }
 
-QList<KPluginMetaData> PluginLoader::listAppletMetaData(const QString &category)
+void PluginLoader::preloadContainmentActions(const QStringList &names)
 {
-    auto platforms = KRuntimePlatform::runtimePlatform();
-    // For now desktop always lists everything
-    if (platforms.contains(QStringLiteral("desktop"))) {
-        platforms.clear();
+    for (const QString &name : names) {
+        const KPluginMetaData plugin = d->containmentactionCache.findPluginById(name);
+        if (!plugin.isValid() || d->containmentactionCache.hasFactory(plugin.pluginId())) {
+            continue;
+        }
+
+        // dlopen on the pool, get the factory back on the main thread
+        PluginLoaderPrivate *loader = d;
+        d->threadPool.start([loader, plugin]() {
+            if (!plugin.isStaticPlugin()) {
+                PluginLoaderPrivate::preloadLibrary(plugin.fileName());
+            }
+            QMetaObject::invokeMethod(
+                &loader->mainThreadContext,
+                [loader, plugin]() {
+                    if (loader->containmentactionCache.hasFactory(plugin.pluginId())) {
+                        return;
+                    }
+                    if (KPluginFactory *factory = KPluginFactory::loadFactory(plugin).plugin) {
+                        loader->containmentactionCache.insertFactory(plugin.pluginId(), factory);
+                        loader->containmentactionCache.watchPluginFile(plugin);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
     }
+}
 
+QList<KPluginMetaData> PluginLoader::listAppletMetaData(const QString &category)
+{
     // FIXME: this assumes we are always use packages.. no pure c++
-    std::function<bool(const KPluginMetaData &)> filter;
     if (category.isEmpty()) { // use all but the excluded categories
         KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("General"));
-        QStringList excluded = group.readEntry("ExcludeCategories", QStringList());
-
-        filter = [excluded, platforms](const KPluginMetaData &md) -> bool {
-            if (!platforms.isEmpty() && !md.formFactors().isEmpty()) {
-                bool found = false;
-                for (const auto &plat : platforms) {
-                    if (md.formFactors().contains(plat)) {
-                        found = true;
-                        break;
-                    }
-                }
-
-                if (!found) {
-                    return false;
-                }
-            }
-
-            return !excluded.contains(md.category());
-        };
-    } else { // specific category (this could be an excluded one - is that bad?)
-
-        filter = [category, platforms](const KPluginMetaData &md) -> bool {
-            if (!platforms.isEmpty() && !md.formFactors().isEmpty()) {
-                bool found = false;
-                for (const auto &plat : platforms) {
-                    if (md.formFactors().contains(plat)) {
-                        found = true;
-                        break;
-                    }
-                }
-
-                if (!found) {
-                    return false;
-                }
-            }
-
-            if (category == QLatin1String("Miscellaneous")) {
-                return md.category() == category || md.category().isEmpty();
-            } else {
-                return md.category() == category;
-            }
-        };
+        const QStringList excluded = group.readEntry("ExcludeCategories", QStringList());
+        return d->appletIndex.metaDataForCategories({}, excluded, d->runtimePlatforms());
     }
 
-    return KPackage::PackageLoader::self()->findPackages(QStringLiteral("Plasma/Applet"), QString(), filter);
+    // specific category (this could be an excluded one - is that bad?)
+    if (category == QLatin1String("Miscellaneous")) {
+        return d->appletIndex.metaDataForCategories({category, QString()}, {}, d->runtimePlatforms());
+    }
+    return d->appletIndex.metaDataForCategories({category}, {}, d->runtimePlatforms());
 }
 
 QList<KPluginMetaData> PluginLoader::listAppletMetaDataForMimeType(const QString &mimeType)
 {
-    auto filter = [&mimeType](const KPluginMetaData &md) -> bool {
-        return md.value(QStringLiteral("X-Plasma-DropMimeTypes"), QStringList()).contains(mimeType);
-    };
-    return KPackage::PackageLoader::self()->findPackages(QStringLiteral("Plasma/Applet"), QString(), filter);
+    return listAppletMetaDataForMimeType(mimeType, ExactMimeTypeMatch);
 }
 
-QList<KPluginMetaData> PluginLoader::listAppletMetaDataForUrl(const QUrl &url)
+QList<KPluginMetaData> PluginLoader::listAppletMetaDataForMimeType(const QString &mimeType, MimeTypeMatching matching)
 {
-    auto filter = [](const KPluginMetaData &md) -> bool {
-        return !md.value(QStringLiteral("X-Plasma-DropUrlPatterns"), QStringList()).isEmpty();
-    };
-    const QList<KPluginMetaData> allApplets = KPackage::PackageLoader::self()->findPackages(QStringLiteral("Plasma/Applet"), QString(), filter);
-
-    QList<KPluginMetaData> filtered;
-    for (const KPluginMetaData &md : allApplets) {
-        const QStringList urlPatterns = md.value(QStringLiteral("X-Plasma-DropUrlPatterns"), QStringList());
-        for (const QString &glob : urlPatterns) {
-            QRegularExpression rx(QRegularExpression::anchoredPattern(QRegularExpression::wildcardToRegularExpression(glob)));
-            if (rx.match(url.toString()).hasMatch()) {
-                filtered << md;
+    QStringList mimeTypes{mimeType};
+
+    if (matching == InheritedMimeTypeMatch) {
+        const QMimeType type = QMimeDatabase().mimeTypeForName(mimeType);
+        if (type.isValid()) {
+            mimeTypes << type.name() << type.aliases() << type.allAncestors();
+        }
+
+        // image/png, image/* and the same for the parents
+        const QStringList names = mimeTypes;
+        for (const QString &name : names) {
+            const qsizetype slash = name.indexOf(QLatin1Char('/'));
+            if (slash > 0) {
+                mimeTypes << name.left(slash) + QLatin1String("/*");
             }
         }
+        mimeTypes.removeDuplicates();
     }
 
-    return filtered;
+    return d->appletIndex.metaDataForMimeTypes(mimeTypes);
+}
+
+QList<KPluginMetaData> PluginLoader::listAppletMetaDataForUrl(const QUrl &url)
+{
+    return d->appletIndex.metaDataForUrl(url);
+}
+
+QList<KPluginMetaData> PluginLoader::listAppletMetaDataForProvides(const QStringList &provides)
+{
+    return d->appletIndex.metaDataForProvides(provides);
 }
 
 QList<KPluginMetaData> PluginLoader::listContainmentsMetaData(std::function<bool(const KPluginMetaData &)> filter)
 {
-    auto ownFilter = [filter](const KPluginMetaData &md) -> bool {
-        return isContainmentMetaData(md) && filter(md);
+    auto isContainment = [](const AppletIndex::Entry &entry) -> bool {
+        return entry.isContainment;
     };
 
-    return KPackage::PackageLoader::self()->findPackages(QStringLiteral("Plasma/Applet"), QString(), ownFilter);
+    QList<KPluginMetaData> containments = self()->d->appletIndex.metaData(isContainment);
+    if (filter) {
+        containments.removeIf([&filter](const KPluginMetaData &md) {
+            return !filter(md);
+        });
+    }
+    return containments;
 }
 
 QList<KPluginMetaData> PluginLoader::listContainmentsMetaDataOfType(const QString &type)
 {
-    auto filter = [type](const KPluginMetaData &md) -> bool {
-        return md.value(QStringLiteral("X-Plasma-ContainmentType")) == type;
+    auto filter = [type](const AppletIndex::Entry &entry) -> bool {
+        return entry.isContainment && entry.containmentType == type;
     };
 
-    return listContainmentsMetaData(filter);
+    return self()->d->appletIndex.metaData(filter);
 }
 
 QList<KPluginMetaData> PluginLoader::listContainmentActionsMetaData(const QString &parentApp)
 {
-    auto filter = [&parentApp](const KPluginMetaData &md) -> bool {
-        return md.value(QStringLiteral("X-KDE-ParentApp")) == parentApp;
-    };
+    return d->containmentactionCache.pluginsForParentApp(parentApp);
+}
 
-    QList<KPluginMetaData> plugins;
-    if (parentApp.isEmpty()) {
-        plugins = KPluginMetaData::findPlugins(PluginLoaderPrivate::s_containmentActionsPluginDir);
-    } else {
-        plugins = KPluginMetaData::findPlugins(PluginLoaderPrivate::s_containmentActionsPluginDir, filter);
-    }
+PluginLoader::PluginCacheStatistics PluginLoader::appletPluginCacheStatistics() const
+{
+    return d->plasmoidCache.statistics();
+}
 
-    return plugins;
+PluginLoader::PluginCacheStatistics PluginLoader::containmentActionsPluginCacheStatistics() const
+{
+    return d->containmentactionCache.statistics();
 }
 
-KPluginMetaData PluginLoaderPrivate::Cache::findPluginById(const QString &name, const QString &pluginNamespace)
+const QStringList &PluginLoaderPrivate::runtimePlatforms()
 {
-    const qint64 now = qRound64(QDateTime::currentMSecsSinceEpoch() / 1000.0);
-    bool useRuntimeCache = true;
+    if (!platforms) {
+        platforms = KRuntimePlatform::runtimePlatform();
+        // For now desktop always lists everything
+        if (platforms->contains(QStringLiteral("desktop"))) {
+            platforms->clear();
+        }
+    }
+    return *platforms;
+}
 
-    if (pluginCacheAge == 0) {
-        // Find all the plugins now, but only once
-        pluginCacheAge = now;
+void PluginLoaderPrivate::preloadLibrary(const QString &fileName)
+{
+    // dlopen and relocate here, KPluginFactory::loadFactory on the main thread will find the library already loaded
+    Tracer::Scope trace("preloadLibrary", fileName);
+    QPluginLoader loader(fileName);
+    if (!loader.load()) {
+        qCDebug(LOG_PLASMA) << "Could not preload" << fileName << loader.errorString();
+    }
+}
 
-        const auto metaDataList = KPluginMetaData::findPlugins(pluginNamespace, {}, KPluginMetaData::AllowEmptyMetaData);
-        for (const KPluginMetaData &metadata : metaDataList) {
-            plugins.insert(metadata.pluginId(), metadata);
+void PluginLoaderPrivate::preloadPackageFiles(const QString &packageDir)
+{
+    // reading them once is enough to have them in the page cache when the QML engine gets to them
+    Tracer::Scope trace("preloadPackage", packageDir);
+    QDirIterator it(packageDir,
+                    {QStringLiteral("*.qml"), QStringLiteral("*.js"), QStringLiteral("*.json"), QStringLiteral("*.xml")},
+                    QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QFile file(it.next());
+        if (file.open(QIODevice::ReadOnly)) {
+            file.readAll();
         }
-    } else if (now - pluginCacheAge > maxCacheAge) {
-        // cache is old and we're not within a few seconds of startup anymore
-        useRuntimeCache = false;
-        plugins.clear();
     }
+}
 
+PluginLoaderPrivate::Cache::Cache(const QString &pluginNamespace)
+    : pluginNamespace(pluginNamespace)
+{
+}
+
+PluginLoaderPrivate::Cache::~Cache()
+{
+    delete watcher;
+}
+
+KPluginMetaData PluginLoaderPrivate::Cache::findPluginById(const QString &name)
+{
     // if name wasn't a path, pluginName == name
     const QString pluginName = name.section(QLatin1Char('/'), -1);
 
-    if (useRuntimeCache) {
-        KPluginMetaData data = plugins.value(name);
-        qCDebug(LOG_PLASMA) << "loading applet by name" << name << useRuntimeCache << data.isValid();
+    QMutexLocker locker(&mutex);
+    if (ensurePopulated()) {
+        KPluginMetaData data = plugins.value(pluginName);
+        qCDebug(LOG_PLASMA) << "loading plugin by name" << name << data.isValid();
         return data;
+    }
+
+    // we can't watch the plugin directories from here, so we can't cache either
+    locker.unlock();
+    const QList<KPluginMetaData> offers = KPluginMetaData::findPlugins(
+        pluginNamespace,
+        [&pluginName](const KPluginMetaData &data) {
+            return data.pluginId() == pluginName;
+        },
+        KPluginMetaData::AllowEmptyMetaData);
+    return offers.isEmpty() ? KPluginMetaData() : offers.first();
+}
+
+QList<KPluginMetaData> PluginLoaderPrivate::Cache::pluginsForParentApp(const QString &parentApp)
+{
+    QMutexLocker locker(&mutex);
+    if (ensurePopulated()) {
+        return parentApp.isEmpty() ? listedPlugins : pluginsByParentApp.value(parentApp);
+    }
+
+    locker.unlock();
+    if (parentApp.isEmpty()) {
+        return KPluginMetaData::findPlugins(pluginNamespace);
+    }
+    return KPluginMetaData::findPlugins(pluginNamespace, [&parentApp](const KPluginMetaData &md) {
+        return md.value(QStringLiteral("X-KDE-ParentApp")) == parentApp;
+    });
+}
+
+PluginLoader::PluginCacheStatistics PluginLoaderPrivate::Cache::statistics() const
+{
+    QMutexLocker locker(&mutex);
+    return stats;
+}
+
+void PluginLoaderPrivate::Cache::watchPluginDirectories()
+{
+    Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
+
+    QMutexLocker locker(&mutex);
+    if (!watcher) {
+        createWatcher();
+    }
+}
+
+void PluginLoaderPrivate::Cache::watchPluginFile(const KPluginMetaData &plugin)
+{
+    // updating a plugin in place, without touching its directory, only shows up on the file
+    QMutexLocker locker(&mutex);
+    if (!watcher || plugin.isStaticPlugin() || QThread::currentThread() != watcher->thread() || watchedFiles.contains(plugin.fileName())) {
+        return;
+    }
+    if (watcher->addPath(plugin.fileName())) {
+        watchedFiles.insert(plugin.fileName());
+    }
+}
+
+KPluginFactory *PluginLoaderPrivate::Cache::factory(const QString &pluginId)
+{
+    QMutexLocker locker(&mutex);
+    KPluginFactory *factory = factories.value(pluginId);
+    if (factory) {
+        ++stats.factoryHits;
     } else {
-        const QList<KPluginMetaData> offers = KPluginMetaData::findPlugins(
-            pluginNamespace,
-            [&pluginName](const KPluginMetaData &data) {
-                return data.pluginId() == pluginName;
-            },
-            KPluginMetaData::AllowEmptyMetaData);
-        return offers.isEmpty() ? KPluginMetaData() : offers.first();
+        ++stats.factoryMisses;
+    }
+    return factory;
+}
+
+bool PluginLoaderPrivate::Cache::hasFactory(const QString &pluginId) const
+{
+    QMutexLocker locker(&mutex);
+    return factories.contains(pluginId);
+}
+
+void PluginLoaderPrivate::Cache::insertFactory(const QString &pluginId, KPluginFactory *factory)
+{
+    QMutexLocker locker(&mutex);
+    factories.insert(pluginId, factory);
+}
+
+void PluginLoaderPrivate::Cache::createWatcher()
+{
+    watcher = new QFileSystemWatcher(QCoreApplication::instance());
+    updateWatchedDirectories();
+
+    QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, watcher, [this](const QString &path) {
+        QMutexLocker locker(&mutex);
+        const QStringList previous = watchedDirectories;
+        updateWatchedDirectories();
+        // a parent changing only matters when the plugin directory itself appeared or went away
+        const bool changed = watchedDirectories != previous || path.endsWith(pluginNamespace);
+        locker.unlock();
+        if (changed) {
+            invalidate();
+        }
+    });
+    QObject::connect(watcher, &QFileSystemWatcher::fileChanged, watcher, [this](const QString &path) {
+        QMutexLocker locker(&mutex);
+        // replacing the file drops the watch on it, pick the new one up
+        watchedFiles.remove(path);
+        if (QFileInfo::exists(path) && watcher->addPath(path)) {
+            watchedFiles.insert(path);
+        }
+        locker.unlock();
+        invalidate();
+    });
+}
+
+void PluginLoaderPrivate::Cache::updateWatchedDirectories()
+{
+    QStringList dirs;
+    const QStringList libraryPaths = QCoreApplication::libraryPaths();
+    for (const QString &libraryPath : libraryPaths) {
+        // watch the closest existing parent of plugin directories not there yet, to notice them getting created
+        QString dir = libraryPath + QLatin1Char('/') + pluginNamespace;
+        while (!QFileInfo(dir).isDir() && dir.length() > libraryPath.length()) {
+            dir = dir.section(QLatin1Char('/'), 0, -2);
+        }
+        if (QFileInfo(dir).isDir() && !dirs.contains(dir)) {
+            dirs << dir;
+        }
+    }
+
+    if (!watchedDirectories.isEmpty()) {
+        watcher->removePaths(watchedDirectories);
+    }
+    watchedDirectories = dirs;
+    if (!watchedDirectories.isEmpty()) {
+        watcher->addPaths(watchedDirectories);
+    }
+}
+
+bool PluginLoaderPrivate::Cache::ensurePopulated()
+{
+    if (populated) {
+        ++stats.hits;
+        return true;
+    }
+
+    ++stats.misses;
+    return populate();
+}
+
+bool PluginLoaderPrivate::Cache::populate()
+{
+    if (!watcher) {
+        // the watcher needs to live in a thread with an event loop
+        QCoreApplication *app = QCoreApplication::instance();
+        if (!app || QThread::currentThread() != app->thread()) {
+            return false;
+        }
+        createWatcher();
+    }
+
+    const auto metaDataList = KPluginMetaData::findPlugins(pluginNamespace, {}, KPluginMetaData::AllowEmptyMetaData);
+    for (const KPluginMetaData &metadata : metaDataList) {
+        plugins.insert(metadata.pluginId(), metadata);
+        // listings never had the plugins without metadata
+        if (!metadata.rawData().isEmpty()) {
+            listedPlugins << metadata;
+            pluginsByParentApp[metadata.value(QStringLiteral("X-KDE-ParentApp"))] << metadata;
+        }
     }
+    populated = true;
+    return true;
+}
+
+void PluginLoaderPrivate::Cache::invalidate()
+{
+    QMutexLocker locker(&mutex);
+    plugins.clear();
+    listedPlugins.clear();
+    pluginsByParentApp.clear();
+    // a factory of a plugin which got updated or removed must not be used anymore
+    factories.clear();
+    populated = false;
+    ++stats.invalidations;
+
+    qCDebug(LOG_PLASMA) << "plugin directory" << pluginNamespace << "changed, dropping the plugin cache. Hits:" << stats.hits
+                        << "misses:" << stats.misses << "invalidations:" << stats.invalidations;
 }
 
 } // Plasma Namespace
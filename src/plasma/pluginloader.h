@@ -11,6 +11,8 @@
 
 #include <plasma/plasma.h>
 
+#include <QFuture>
+#include <QHash>
 #include <QVariant>
 
 class KPluginMetaData;
@@ -54,6 +56,82 @@ public:
      **/
     Applet *loadApplet(const QString &name, uint appletId = 0, const QVariantList &args = QVariantList());
 
+    /**
+     * Asynchronous version of loadApplet().
+     *
+     * Looking up the plugin, resolving the package and its metadata, registering
+     * its translations and loading the plugin library happen on a worker thread.
+     * The Applet itself is then created on the main thread, so the event loop
+     * keeps running while the plugin is searched and dlopen()ed.
+     *
+     * The applet id is assigned right away, so applets keep the ids they would
+     * get by calling loadApplet() in the same order.
+     * Canceling the returned future before it is finished prevents the
+     * applet from being created.
+     *
+     * @param name the plugin name, as returned by KPluginInfo::pluginName()
+     * @param appletId unique ID to assign the applet, or zero to have one
+     *        assigned automatically.
+     * @param args to send the applet extra arguments
+     * @return a future resolving to the loaded applet, or nullptr on load failure.
+     *         The caller takes ownership of the applet.
+     * @since 6.0
+     **/
+    QFuture<Applet *> loadAppletAsync(const QString &name, uint appletId = 0, const QVariantList &args = QVariantList());
+
+    /**
+     * Describes one of the applets to load with loadApplets()
+     * @since 6.0
+     */
+    struct AppletSpec {
+        // the plugin name, as returned by KPluginInfo::pluginName()
+        QString name;
+        // unique ID to assign the applet, or zero to have one assigned automatically
+        uint appletId = 0;
+        QVariantList args;
+    };
+
+    /**
+     * Load many Applet plugins at once, as done when restoring a containment.
+     *
+     * Gives the same result as calling loadApplet() for every entry of @p specs,
+     * but each package is looked up only once no matter how many applets use it,
+     * and the plugins and packages not known yet are looked up in parallel on
+     * worker threads. The applets then get created one after the other on the
+     * calling thread, in the order of @p specs.
+     *
+     * @param specs the applets to load
+     * @return the loaded applets, in the same order as @p specs, with nullptr
+     *         for the ones that failed to load
+     * @since 6.0
+     **/
+    QList<Applet *> loadApplets(const QList<AppletSpec> &specs);
+
+    /**
+     * Warms up the given Applet plugins in the background, so that loading
+     * them afterwards does not have to wait on the disk.
+     *
+     * On low priority worker threads the plugin libraries get loaded and the
+     * files of the packages read once, to have them in the page cache. Returns
+     * right away; loading an applet which is still being prefetched just works.
+     *
+     * @param names the plugin names, as returned by KPluginInfo::pluginName()
+     * @since 6.0
+     **/
+    void prefetchApplets(const QStringList &names);
+
+    /**
+     * How early the given Applet plugins want to be restored at startup, as
+     * said by the X-Plasma-StartupPriority key of their metadata: applets with
+     * a higher priority are restored first, applets with a negative one only
+     * once everything else got restored.
+     *
+     * @param names the plugin names, as returned by KPluginInfo::pluginName()
+     * @return the priority of each of @p names which has one
+     * @since 6.0
+     **/
+    QHash<QString, int> appletStartupPriorities(const QStringList &names);
+
     /**
      * Load a ContainmentActions plugin.
      *
@@ -68,6 +146,18 @@ public:
      **/
     ContainmentActions *loadContainmentActions(Containment *parent, const QString &containmentActionsName, const QVariantList &args = QVariantList());
 
+    /**
+     * Loads the libraries of the given ContainmentActions plugins in the
+     * background and keeps their factories around for the lifetime of the
+     * loader, so that loadContainmentActions() does not have to hit the disk
+     * for them. Meant for the plugins bound to the default triggers, like the
+     * desktop context menu.
+     *
+     * @param names the plugin names, as returned by KPluginInfo::pluginName()
+     * @since 6.0
+     **/
+    void preloadContainmentActions(const QStringList &names);
+
     /**
      * Returns a list of all known applets.
      * This may skip applets based on security settings and ExcludeCategories in the application's config.
@@ -91,6 +181,27 @@ public:
      **/
     QList<KPluginMetaData> listAppletMetaDataForMimeType(const QString &mimetype);
 
+    /**
+     * How mimetypes are matched against the X-Plasma-DropMimeTypes of the applets
+     * @since 6.0
+     */
+    enum MimeTypeMatching {
+        ExactMimeTypeMatch = 0, /**< Only applets listing the very same mimetype */
+        InheritedMimeTypeMatch, /**< Also applets listing an alias or a parent of the mimetype, or a wildcard like image/* */
+    };
+
+    /**
+     * Returns a list of all known applets associated with a certain mimetype.
+     *
+     * With InheritedMimeTypeMatch a drop of image/png also offers the applets
+     * accepting image/* or any of the mimetypes image/png inherits from,
+     * according to QMimeDatabase.
+     *
+     * @return list of applets
+     * @since 6.0
+     **/
+    QList<KPluginMetaData> listAppletMetaDataForMimeType(const QString &mimetype, MimeTypeMatching matching);
+
     /**
      * Returns a list of all known applets associated with a certain URL.
      *
@@ -99,6 +210,17 @@ public:
      **/
     QList<KPluginMetaData> listAppletMetaDataForUrl(const QUrl &url);
 
+    /**
+     * Returns a list of all known applets providing any of the given features,
+     * as listed in their X-Plasma-Provides: the alternatives an applet can be
+     * switched to are the ones providing what it provides.
+     *
+     * @param provides the features, like org.kde.plasma.multimediacontrols
+     * @return list of applets
+     * @since 6.0
+     **/
+    QList<KPluginMetaData> listAppletMetaDataForProvides(const QStringList &provides);
+
     /**
      * Returns a list of all known containments.
      *
@@ -129,6 +251,36 @@ public:
      **/
     QList<KPluginMetaData> listContainmentActionsMetaData(const QString &parentApp);
 
+    /**
+     * Counters of a plugin lookup cache, meant for diagnostics.
+     *
+     * @since 6.0
+     */
+    struct PluginCacheStatistics {
+        /** lookups answered out of the cache */
+        quint64 hits = 0;
+        /** lookups that had to walk the plugin directories */
+        quint64 misses = 0;
+        /** how many times the cache got dropped because a plugin directory changed */
+        quint64 invalidations = 0;
+        /** plugins created out of a factory kept loaded by preloadContainmentActions() */
+        quint64 factoryHits = 0;
+        /** plugins created by loading their factory, as none was kept loaded */
+        quint64 factoryMisses = 0;
+    };
+
+    /**
+     * @return the counters of the cache used to look up Applet plugins
+     * @since 6.0
+     */
+    PluginCacheStatistics appletPluginCacheStatistics() const;
+
+    /**
+     * @return the counters of the cache used to look up ContainmentActions plugins
+     * @since 6.0
+     */
+    PluginCacheStatistics containmentActionsPluginCacheStatistics() const;
+
     /**
      * Return the active plugin loader
      **/
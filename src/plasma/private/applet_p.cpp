@@ -25,14 +25,15 @@
 #include <KConfigLoader>
 #include <KGlobalAccel>
 #include <KLocalizedString>
-#include <kpackage/packageloader.h>
 
 #include "containment.h"
 #include "corona.h"
 #include "debug_p.h"
 #include "pluginloader.h"
 #include "private/containment_p.h"
-#include "timetracker.h"
+#include "private/corona_p.h"
+#include "private/packageregistry_p.h"
+#include "private/tracer_p.h"
 
 namespace Plasma
 {
@@ -60,6 +61,8 @@ AppletPrivate::AppletPrivate(const KPluginMetaData &info, int uniqueID, Applet *
     , globalShortcutEnabled(false)
     , userConfiguring(false)
     , busy(false)
+    , configDirty(true)
+    , createdAt(Tracer::now())
 {
     if (appletId == 0) {
         appletId = ++s_maxAppletId;
@@ -67,11 +70,9 @@ AppletPrivate::AppletPrivate(const KPluginMetaData &info, int uniqueID, Applet *
         s_maxAppletId = appletId;
     }
     QObject::connect(actions.value(QStringLiteral("configure")), SIGNAL(triggered()), q, SLOT(requestConfiguration()));
-#ifndef NDEBUG
-    if (qEnvironmentVariableIsSet("PLASMA_TRACK_STARTUP")) {
-        new TimeTracker(q);
-    }
-#endif
+    QObject::connect(q, &Applet::configNeedsSaving, q, [this]() {
+        configDirty = true;
+    });
 
     for (auto it = actions.constBegin(); it != actions.constEnd(); ++it) {
         QAction *action = it.value();
@@ -130,8 +131,7 @@ void AppletPrivate::init(const QVariantList &args)
             path = packagePath.isEmpty() ? appletDescription.pluginId() : packagePath;
         }
 
-        package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Plasma/Applet"));
-        package.setPath(path);
+        package = PackageRegistry::self()->package(appletDescription.pluginId(), path);
 
         if (!package.isValid()) {
             q->setLaunchErrorMessage(i18nc("Package file, name of the widget",
@@ -157,20 +157,8 @@ void AppletPrivate::init(const QVariantList &args)
 
             const QStringList provides = q->pluginMetaData().value(QStringLiteral("X-Plasma-Provides"), QStringList());
             if (!provides.isEmpty() && q->immutability() == Types::Mutable) {
-                auto filter = [&provides](const KPluginMetaData &md) -> bool {
-                    const QStringList provided = md.value(QStringLiteral("X-Plasma-Provides"), QStringList());
-                    for (const QString &p : provides) {
-                        if (provided.contains(p)) {
-                            return true;
-                        }
-                    }
-                    return false;
-                };
-                QList<KPluginMetaData> applets = KPackage::PackageLoader::self()->findPackages(QStringLiteral("Plasma/Applet"), QString(), filter);
-
-                if (applets.count() > 1) {
-                    hasAlternatives = true;
-                }
+                // the applet itself is one of them
+                hasAlternatives = PluginLoader::self()->listAppletMetaDataForProvides(provides).count() > 1;
             }
             a->setVisible(hasAlternatives);
         });
@@ -427,6 +415,7 @@ void AppletPrivate::requestConfiguration()
 
 void AppletPrivate::propagateConfigChanged()
 {
+    configDirty = true;
     Containment *c = qobject_cast<Containment *>(q);
     if (c) {
         c->d->configChanged();
@@ -438,9 +427,21 @@ void AppletPrivate::setUiReady()
 {
     // am i the containment?
     Containment *c = qobject_cast<Containment *>(q);
+    if (uiReadyConstraintAt < 0) {
+        uiReadyConstraintAt = Tracer::now();
+    }
+
     if (c && c->isContainment()) {
+        // it's ready only once its applets are, see CoronaPrivate::setupContainment
         c->d->setUiReady();
-    } else if (Containment *cc = q->containment()) {
+        return;
+    }
+
+    if (uiReadyAt < 0) {
+        uiReadyAt = uiReadyConstraintAt;
+        Tracer::span("appletUiReady", createdAt, q->pluginName());
+    }
+    if (Containment *cc = q->containment()) {
         cc->d->appletLoaded(q);
     }
 }
@@ -482,8 +483,15 @@ void AppletPrivate::scheduleConstraintsUpdate(Applet::Constraints c)
 {
     // Don't start up a timer if we're just starting up
     // flushPendingConstraints will be called by Corona
-    if (started && !constraintsTimer.isActive() && !(c & Applet::StartupCompletedConstraint)) {
-        constraintsTimer.start(0, q);
+    if (started && !(c & Applet::StartupCompletedConstraint)) {
+        // the Corona flushes the constraints of all its applets together
+        Containment *containment = q->containment();
+        Corona *corona = containment ? containment->corona() : nullptr;
+        if (corona) {
+            corona->d->scheduleConstraintsFlush(q);
+        } else if (!constraintsTimer.isActive()) {
+            constraintsTimer.start(0, q);
+        }
     }
 
     if (c & Applet::StartupCompletedConstraint) {
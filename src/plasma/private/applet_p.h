@@ -120,6 +120,19 @@ public:
     bool globalShortcutEnabled : 1;
     bool userConfiguring : 1;
     bool busy : 1;
+    // something changed since the last time the layout got saved to our main config group
+    bool configDirty : 1;
+    // waiting in the constraints flush of the Corona
+    bool constraintsQueued = false;
+
+    // when this went through the steps of getting loaded, on the Tracer clock, -1 for what did not happen yet
+    qint64 createdAt;
+    qint64 initializedAt = -1;
+    qint64 restoredAt = -1;
+    qint64 qmlLoadedAt = -1;
+    qint64 uiReadyConstraintAt = -1;
+    // the same as uiReadyConstraintAt for applets, containments get ready only once their applets are
+    qint64 uiReadyAt = -1;
 };
 
 } // Plasma namespace
@@ -0,0 +1,451 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "private/appletindex_p.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
+
+#include <kpackage/packageloader.h>
+
+#include <algorithm>
+
+#include "debug_p.h"
+
+namespace Plasma
+{
+// "PLAI", bump s_indexVersion every time the serialized Entry changes
+static const quint32 s_indexMagic = 0x504c4149;
+static const quint32 s_indexVersion = 2;
+
+static qint64 lastModified(const QString &path)
+{
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+static QDataStream &operator<<(QDataStream &stream, const AppletIndex::Entry &entry)
+{
+    stream << entry.pluginId << entry.category << entry.containmentType << entry.formFactors << entry.provides << entry.dropMimeTypes
+           << entry.dropUrlPatterns << entry.fileName << entry.rawData << entry.packageMTime << entry.metaDataMTime << entry.isContainment;
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, AppletIndex::Entry &entry)
+{
+    stream >> entry.pluginId >> entry.category >> entry.containmentType >> entry.formFactors >> entry.provides >> entry.dropMimeTypes
+        >> entry.dropUrlPatterns >> entry.fileName >> entry.rawData >> entry.packageMTime >> entry.metaDataMTime >> entry.isContainment;
+    return stream;
+}
+
+// Adding or removing files only touches the package directory, editing
+// metadata.json in place only touches the file itself
+static bool isUpToDate(const AppletIndex::Entry &entry)
+{
+    const QFileInfo info(entry.fileName);
+    return entry.metaDataMTime == info.lastModified().toMSecsSinceEpoch() && entry.packageMTime == lastModified(info.path());
+}
+
+AppletIndex::AppletIndex()
+{
+}
+
+AppletIndex::~AppletIndex()
+{
+    delete m_watcher;
+}
+
+QString AppletIndex::cacheFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma/appletindex.cache");
+}
+
+QList<KPluginMetaData> AppletIndex::metaData(const std::function<bool(const Entry &)> &filter)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureUpToDate();
+
+    QList<KPluginMetaData> list;
+    for (int i = 0; i < m_entries.count(); ++i) {
+        if (!filter || filter(m_entries.at(i))) {
+            list << metaDataAt(i);
+        }
+    }
+    return list;
+}
+
+QList<KPluginMetaData> AppletIndex::metaDataForMimeTypes(const QStringList &mimeTypes)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureUpToDate();
+
+    QList<int> positions;
+    for (const QString &mimeType : mimeTypes) {
+        positions << m_mimeTypeIndex.value(mimeType);
+    }
+    // keep the same order as a full scan would give
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    QList<KPluginMetaData> list;
+    list.reserve(positions.count());
+    for (int i : std::as_const(positions)) {
+        list << metaDataAt(i);
+    }
+    return list;
+}
+
+QList<KPluginMetaData> AppletIndex::metaDataForProvides(const QStringList &provides)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureUpToDate();
+
+    QList<int> positions;
+    for (const QString &provided : provides) {
+        positions << m_providesIndex.value(provided);
+    }
+    // keep the same order as a full scan would give
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    QList<KPluginMetaData> list;
+    list.reserve(positions.count());
+    for (int i : std::as_const(positions)) {
+        list << metaDataAt(i);
+    }
+    return list;
+}
+
+QList<KPluginMetaData> AppletIndex::metaDataForUrl(const QUrl &url)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureUpToDate();
+
+    QList<KPluginMetaData> list;
+    if (m_urlMatcherGroups.isEmpty()) {
+        return list;
+    }
+
+    const QRegularExpressionMatch match = m_urlMatcher.match(url.toString());
+    for (const auto &[group, position] : std::as_const(m_urlMatcherGroups)) {
+        if (match.capturedStart(group) >= 0) {
+            list << metaDataAt(position);
+        }
+    }
+    return list;
+}
+
+QList<KPluginMetaData> AppletIndex::metaDataForCategories(const QStringList &categories, const QStringList &excludedCategories, const QStringList &formFactors)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureUpToDate();
+
+    QList<int> positions;
+    if (categories.isEmpty()) {
+        for (auto it = m_categoryIndex.cbegin(); it != m_categoryIndex.cend(); ++it) {
+            if (!excludedCategories.contains(it.key())) {
+                positions << it.value();
+            }
+        }
+    } else {
+        for (const QString &category : categories) {
+            positions << m_categoryIndex.value(category);
+        }
+    }
+
+    if (!formFactors.isEmpty()) {
+        QList<bool> supported(m_entries.count(), false);
+        for (int i : std::as_const(m_anyFormFactor)) {
+            supported[i] = true;
+        }
+        for (const QString &formFactor : formFactors) {
+            for (int i : m_formFactorIndex.value(formFactor)) {
+                supported[i] = true;
+            }
+        }
+        positions.removeIf([&supported](int i) {
+            return !supported.at(i);
+        });
+    }
+
+    // keep the same order as a full scan would give
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    QList<KPluginMetaData> list;
+    list.reserve(positions.count());
+    for (int i : std::as_const(positions)) {
+        list << metaDataAt(i);
+    }
+    return list;
+}
+
+void AppletIndex::ensureUpToDate()
+{
+    if (m_loaded && !m_changed) {
+        // nothing changed unless the watcher told so: lookups don't touch the disk
+        if (m_watcher) {
+            return;
+        }
+        // Installing or removing a package touches the root directory it lives in,
+        // changes to an installed package only show up in its own directory
+        if (packageRoots() == m_roots && std::all_of(m_entries.cbegin(), m_entries.cend(), isUpToDate)) {
+            updateWatcher();
+            return;
+        }
+    }
+
+    const QHash<QString, qint64> roots = packageRoots();
+
+    if (!loadCache(roots)) {
+        rebuild(roots);
+        saveCache();
+    }
+    m_roots = roots;
+    m_loaded = true;
+    m_changed = false;
+    rebuildDerivedIndexes();
+    updateWatcher();
+}
+
+void AppletIndex::updateWatcher()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app || QThread::currentThread() != app->thread()) {
+        return;
+    }
+
+    if (!m_watcher) {
+        m_watcher = new QFileSystemWatcher(app);
+        QObject::connect(m_watcher, &QFileSystemWatcher::directoryChanged, m_watcher, [this](const QString &path) {
+            QMutexLocker locker(&m_mutex);
+            // a parent watched for a package root to show up only matters when one did
+            if (!m_roots.contains(path) && !std::any_of(m_entries.cbegin(), m_entries.cend(), [&path](const Entry &entry) {
+                    return QFileInfo(entry.fileName).path() == path;
+                })) {
+                const QHash<QString, qint64> roots = packageRoots();
+                if (roots.size() == m_roots.size() && std::all_of(roots.keyBegin(), roots.keyEnd(), [this](const QString &root) {
+                        return m_roots.contains(root);
+                    })) {
+                    return;
+                }
+            }
+            m_changed = true;
+        });
+        QObject::connect(m_watcher, &QFileSystemWatcher::fileChanged, m_watcher, [this]() {
+            QMutexLocker locker(&m_mutex);
+            m_changed = true;
+        });
+    }
+
+    QStringList paths;
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataDir : dataDirs) {
+        QString dir = dataDir + QStringLiteral("/plasma/plasmoids");
+        while (!QFileInfo(dir).isDir() && dir.length() > dataDir.length()) {
+            dir = dir.section(QLatin1Char('/'), 0, -2);
+        }
+        if (QFileInfo(dir).isDir() && !paths.contains(dir)) {
+            paths << dir;
+        }
+    }
+    for (const Entry &entry : std::as_const(m_entries)) {
+        paths << QFileInfo(entry.fileName).path() << entry.fileName;
+    }
+
+    const QStringList watched = m_watcher->directories() + m_watcher->files();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+    m_watcher->addPaths(paths);
+}
+
+QHash<QString, qint64> AppletIndex::packageRoots() const
+{
+    QHash<QString, qint64> roots;
+    const QStringList dirs =
+        QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("plasma/plasmoids"), QStandardPaths::LocateDirectory);
+    for (const QString &dir : dirs) {
+        roots.insert(dir, lastModified(dir));
+    }
+    return roots;
+}
+
+bool AppletIndex::loadCache(const QHash<QString, qint64> &roots)
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_5);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QHash<QString, qint64> cachedRoots;
+    stream >> magic >> version;
+    if (magic != s_indexMagic || version != s_indexVersion) {
+        return false;
+    }
+
+    stream >> cachedRoots;
+    if (cachedRoots != roots) {
+        return false;
+    }
+
+    quint32 count = 0;
+    stream >> count;
+    QList<Entry> entries;
+    entries.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Entry entry;
+        stream >> entry;
+        // something got changed inside the package since we wrote the index
+        if (stream.status() == QDataStream::Ok && !isUpToDate(entry)) {
+            return false;
+        }
+        entries << entry;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCDebug(LOG_PLASMA) << "Discarding corrupted applet index" << file.fileName();
+        return false;
+    }
+
+    m_entries = entries;
+    m_metaData = QList<KPluginMetaData>(m_entries.count());
+    return true;
+}
+
+void AppletIndex::saveCache() const
+{
+    const QString path = cacheFilePath();
+    QDir().mkpath(QFileInfo(path).path());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(LOG_PLASMA) << "Could not write the applet index to" << path << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_5);
+    stream << s_indexMagic << s_indexVersion << m_roots << quint32(m_entries.count());
+    for (const Entry &entry : m_entries) {
+        stream << entry;
+    }
+
+    if (!file.commit()) {
+        qCDebug(LOG_PLASMA) << "Could not write the applet index to" << path << file.errorString();
+    }
+}
+
+void AppletIndex::rebuild(const QHash<QString, qint64> &roots)
+{
+    m_roots = roots;
+    m_entries.clear();
+    m_metaData.clear();
+
+    const QList<KPluginMetaData> packages = KPackage::PackageLoader::self()->findPackages(QStringLiteral("Plasma/Applet"));
+    m_entries.reserve(packages.count());
+    m_metaData.reserve(packages.count());
+
+    for (const KPluginMetaData &md : packages) {
+        Entry entry;
+        entry.pluginId = md.pluginId();
+        entry.category = md.category();
+        entry.containmentType = md.value(QStringLiteral("X-Plasma-ContainmentType"));
+        entry.formFactors = md.formFactors();
+        entry.provides = md.value(QStringLiteral("X-Plasma-Provides"), QStringList());
+        entry.dropMimeTypes = md.value(QStringLiteral("X-Plasma-DropMimeTypes"), QStringList());
+        entry.dropUrlPatterns = md.value(QStringLiteral("X-Plasma-DropUrlPatterns"), QStringList());
+        entry.fileName = md.fileName();
+        entry.rawData = QJsonDocument(md.rawData()).toJson(QJsonDocument::Compact);
+        entry.packageMTime = lastModified(QFileInfo(md.fileName()).path());
+        entry.metaDataMTime = lastModified(md.fileName());
+        entry.isContainment = md.rawData().contains(QStringLiteral("X-Plasma-ContainmentType"));
+
+        m_entries << entry;
+        m_metaData << md;
+    }
+}
+
+void AppletIndex::rebuildDerivedIndexes()
+{
+    m_mimeTypeIndex.clear();
+    m_providesIndex.clear();
+    for (int i = 0; i < m_entries.count(); ++i) {
+        for (const QString &mimeType : std::as_const(m_entries.at(i).dropMimeTypes)) {
+            m_mimeTypeIndex[mimeType] << i;
+        }
+        for (const QString &provided : std::as_const(m_entries.at(i).provides)) {
+            m_providesIndex[provided] << i;
+        }
+    }
+
+    m_categoryIndex.clear();
+    m_formFactorIndex.clear();
+    m_anyFormFactor.clear();
+    for (int i = 0; i < m_entries.count(); ++i) {
+        const Entry &entry = m_entries.at(i);
+        m_categoryIndex[entry.category] << i;
+        if (entry.formFactors.isEmpty()) {
+            m_anyFormFactor << i;
+        }
+        for (const QString &formFactor : entry.formFactors) {
+            m_formFactorIndex[formFactor] << i;
+        }
+    }
+
+    QString urlPattern;
+    m_urlMatcherGroups.clear();
+    for (int i = 0; i < m_entries.count(); ++i) {
+        QStringList globs;
+        for (const QString &glob : std::as_const(m_entries.at(i).dropUrlPatterns)) {
+            const QString rx = QRegularExpression::anchoredPattern(QRegularExpression::wildcardToRegularExpression(glob));
+            if (!QRegularExpression(rx).isValid()) {
+                qCWarning(LOG_PLASMA) << "Ignoring invalid X-Plasma-DropUrlPatterns entry" << glob << "of" << m_entries.at(i).pluginId;
+                continue;
+            }
+            globs << rx;
+        }
+        if (globs.isEmpty()) {
+            continue;
+        }
+
+        const QString group = QStringLiteral("p%1").arg(i);
+        urlPattern += QStringLiteral("(?=(?<%1>%2)?)").arg(group, globs.join(QLatin1Char('|')));
+        m_urlMatcherGroups << qMakePair(group, i);
+    }
+    m_urlMatcher = QRegularExpression(QStringLiteral("\\A") + urlPattern);
+    if (!m_urlMatcherGroups.isEmpty()) {
+        m_urlMatcher.optimize();
+    }
+}
+
+KPluginMetaData AppletIndex::metaDataAt(int index)
+{
+    KPluginMetaData &md = m_metaData[index];
+    if (!md.isValid()) {
+        const Entry &entry = m_entries.at(index);
+        md = KPluginMetaData(QJsonDocument::fromJson(entry.rawData).object(), entry.fileName);
+    }
+    return md;
+}
+
+}
@@ -0,0 +1,143 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef PLASMA_APPLETINDEX_P_H
+#define PLASMA_APPLETINDEX_P_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <KPluginMetaData>
+
+#include <functional>
+
+class QFileSystemWatcher;
+
+namespace Plasma
+{
+/**
+ * @internal
+ *
+ * Index of all the installed Plasma/Applet packages.
+ *
+ * Walking every package directory and parsing every metadata.json is what
+ * KPackage::PackageLoader::findPackages does on each call, which is way too
+ * slow for things like the drop menu with a few hundred plasmoids installed.
+ *
+ * The index keeps the columns the PluginLoader queries on already parsed and
+ * persists them in the user cache directory, from where they are read back on
+ * the next start. The on-disk copy is only trusted as long as the mtimes of
+ * the package roots, of every package directory and of every metadata.json
+ * did not change. The in memory copy is trusted until a watcher on the same
+ * paths reports a change, or with the same checks as the on-disk one when
+ * there is no watcher yet because it couldn't be created from the main thread.
+ */
+class AppletIndex
+{
+public:
+    struct Entry {
+        QString pluginId;
+        QString category;
+        QString containmentType;
+        QStringList formFactors;
+        QStringList provides;
+        QStringList dropMimeTypes;
+        QStringList dropUrlPatterns;
+        // metadata.json of the package and its raw contents, to build the KPluginMetaData
+        QString fileName;
+        QByteArray rawData;
+        qint64 packageMTime = 0;
+        qint64 metaDataMTime = 0;
+        bool isContainment = false;
+    };
+
+    AppletIndex();
+    ~AppletIndex();
+
+    /**
+     * @return metadata of all the packages for which @p filter returns true,
+     *         all of them if no filter is passed
+     */
+    QList<KPluginMetaData> metaData(const std::function<bool(const Entry &)> &filter = {});
+
+    /**
+     * @return metadata of all the packages accepting drops of any of @p mimeTypes,
+     *         as listed in their X-Plasma-DropMimeTypes
+     */
+    QList<KPluginMetaData> metaDataForMimeTypes(const QStringList &mimeTypes);
+
+    /**
+     * @return metadata of all the packages accepting drops of @p url,
+     *         as matched against their X-Plasma-DropUrlPatterns
+     */
+    QList<KPluginMetaData> metaDataForUrl(const QUrl &url);
+
+    /**
+     * @return metadata of all the packages providing any of @p provides,
+     *         as listed in their X-Plasma-Provides
+     */
+    QList<KPluginMetaData> metaDataForProvides(const QStringList &provides);
+
+    /**
+     * @return metadata of the packages in any of @p categories, or in any but
+     *         @p excludedCategories if @p categories is empty. If @p formFactors
+     *         is not empty, only the packages supporting one of them, or not
+     *         saying anything about it, are listed
+     */
+    QList<KPluginMetaData>
+    metaDataForCategories(const QStringList &categories, const QStringList &excludedCategories = {}, const QStringList &formFactors = {});
+
+    /**
+     * @return where the index is stored on disk
+     */
+    static QString cacheFilePath();
+
+private:
+    // all of these expect m_mutex to be locked
+    void ensureUpToDate();
+    QHash<QString, qint64> packageRoots() const;
+    bool loadCache(const QHash<QString, qint64> &roots);
+    void saveCache() const;
+    void rebuild(const QHash<QString, qint64> &roots);
+    void rebuildDerivedIndexes();
+    // has to be called from the main thread, a no-op elsewhere
+    void updateWatcher();
+    KPluginMetaData metaDataAt(int index);
+
+    QMutex m_mutex;
+    QList<Entry> m_entries;
+    // built on demand out of Entry::rawData
+    QList<KPluginMetaData> m_metaData;
+    QHash<QString, qint64> m_roots;
+    // derived out of m_entries, mimetype -> positions in m_entries
+    QHash<QString, QList<int>> m_mimeTypeIndex;
+    // provided feature -> positions in m_entries
+    QHash<QString, QList<int>> m_providesIndex;
+    // all the X-Plasma-DropUrlPatterns compiled in a single expression:
+    // one optional capture in a lookahead per package, so a single match
+    // tells all the packages accepting an url
+    QRegularExpression m_urlMatcher;
+    QList<QPair<QString, int>> m_urlMatcherGroups;
+    // category -> positions in m_entries, uncategorized packages are under ""
+    QHash<QString, QList<int>> m_categoryIndex;
+    // form factor -> positions in m_entries, packages without any are in m_anyFormFactor
+    QHash<QString, QList<int>> m_formFactorIndex;
+    QList<int> m_anyFormFactor;
+    // watches the package roots, or their closest existing parent, every package
+    // directory and every metadata.json; it lives in the main thread, but sets
+    // m_changed under m_mutex
+    QPointer<QFileSystemWatcher> m_watcher;
+    bool m_loaded = false;
+    bool m_changed = false;
+};
+
+}
+
+#endif
@@ -9,9 +9,14 @@
 
 #include "private/containment_p.h"
 
+#include <KConfigLoader>
+#include <KConfigSkeleton>
 #include <KLocalizedString>
 #include <QDebug>
 
+#include <algorithm>
+#include <functional>
+
 #include "config-plasma.h"
 
 #include "pluginloader.h"
@@ -20,6 +25,7 @@
 
 #include "debug_p.h"
 #include "private/applet_p.h"
+#include "private/tracer_p.h"
 
 namespace Plasma
 {
@@ -33,6 +39,8 @@ ContainmentPrivate::ContainmentPrivate(Containment *c)
     , type(Plasma::Containment::Type::NoContainment) // never had a screen
     , uiReady(false)
     , appletsUiReady(false)
+    , restoringPendingApplets(false)
+    , savingChanges(false)
 {
     // if the parent is an applet (i.e we are the systray)
     // we want to follow screen changed signals from the parent's containment
@@ -46,6 +54,13 @@ ContainmentPrivate::ContainmentPrivate(Containment *c)
 
 Plasma::ContainmentPrivate::~ContainmentPrivate()
 {
+    for (PendingApplet &pending : pendingApplets) {
+        if (pending.future.isFinished()) {
+            delete pending.future.result();
+        } else {
+            pending.future.cancel();
+        }
+    }
     applets.clear();
 }
 
@@ -106,16 +121,68 @@ void ContainmentPrivate::checkStatus(Plasma::Types::ItemStatus appletStatus)
     if (appletStatus < q->status() || appletStatus == Plasma::Types::HiddenStatus) {
         // check to see if any other applet has a higher status, and stick with that if we do
         // we'll treat HiddenStatus as lowest as we cannot change the enum value which is highest anymore
-        for (Applet *applet : std::as_const(applets)) {
-            if (applet->status() > appletStatus && applet->status() != Plasma::Types::HiddenStatus) {
-                appletStatus = applet->status();
-            }
+        const Types::ItemStatus highest = highestAppletStatus();
+        if (highest > appletStatus && highest != Plasma::Types::HiddenStatus) {
+            appletStatus = highest;
         }
     }
 
-    if (appletStatus != Plasma::Types::HiddenStatus) {
+    // applets change status all the time while starting, only what changes the containment is worth telling
+    if (appletStatus != Plasma::Types::HiddenStatus && appletStatus != q->status()) {
         q->setStatus(appletStatus);
+        qCDebug(LOG_PLASMA) << "Status of" << q->pluginName() << q->id() << "is now" << appletStatus << "because of" << statusDictatingApplet();
+    }
+}
+
+void ContainmentPrivate::appletStatusChanged(Applet *applet, Types::ItemStatus status)
+{
+    auto it = appletStatuses.find(applet);
+    if (it == appletStatuses.end()) {
+        return;
     }
+
+    --statusCounts[it.value()];
+    ++statusCounts[status];
+    it.value() = status;
+
+    checkStatus(status);
+}
+
+void ContainmentPrivate::trackAppletStatus(Applet *applet)
+{
+    const Types::ItemStatus status = applet->status();
+    appletStatuses.insert(applet, status);
+    ++statusCounts[status];
+}
+
+void ContainmentPrivate::untrackAppletStatus(Applet *applet)
+{
+    // the applet may be being deleted, don't ask it anything
+    auto it = appletStatuses.find(applet);
+    if (it != appletStatuses.end()) {
+        --statusCounts[it.value()];
+        appletStatuses.erase(it);
+    }
+}
+
+Types::ItemStatus ContainmentPrivate::highestAppletStatus() const
+{
+    for (int status = Types::AcceptingInputStatus; status > Types::UnknownStatus; --status) {
+        if (statusCounts[status] > 0) {
+            return Types::ItemStatus(status);
+        }
+    }
+    return statusCounts[Types::UnknownStatus] > 0 ? Types::UnknownStatus : Types::HiddenStatus;
+}
+
+const Applet *ContainmentPrivate::statusDictatingApplet() const
+{
+    for (auto it = appletStatuses.cbegin(); it != appletStatuses.cend(); ++it) {
+        if (it.value() == q->status()) {
+            return it.key();
+        }
+    }
+    return nullptr;
 }
 
 void ContainmentPrivate::triggerShowAddWidgets()
@@ -190,31 +257,293 @@ Applet *ContainmentPrivate::createApplet(const QString &name, const QVariantList
     }
 
     Applet *applet = PluginLoader::self()->loadApplet(name, id, args);
+    return addLoadedApplets({applet}, {PluginLoader::AppletSpec{name, id, args}}, geometryHint).constFirst();
+}
 
-    if (!applet) {
-        qCWarning(LOG_PLASMA) << "Applet" << name << "could not be loaded.";
-        applet = new Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), id});
-        applet->setLaunchErrorMessage(i18n("Could not find requested component: %1", name));
+void ContainmentPrivate::createApplets(const QList<PluginLoader::AppletSpec> &specs)
+{
+    if (!q->isContainment() || specs.isEmpty() || q->immutability() != Types::Mutable) {
+        return;
+    }
+
+    addLoadedApplets(PluginLoader::self()->loadApplets(specs), specs, QRectF(-1, -1, 0, 0));
+}
+
+void ContainmentPrivate::createAppletAsync(const QString &name, uint id)
+{
+    QFuture<Applet *> future = PluginLoader::self()->loadAppletAsync(name, id);
+    pendingApplets << PendingApplet{future, name, id};
+    future.then(q, [this](Applet *) {
+        processPendingApplets();
+    });
+}
+
+void ContainmentPrivate::processPendingApplets()
+{
+    if (pendingApplets.isEmpty()) {
+        return;
+    }
+
+    // keep the restore order, no matter which plugin finished loading first
+    QList<Applet *> loaded;
+    QList<PluginLoader::AppletSpec> specs;
+    while (!pendingApplets.isEmpty() && pendingApplets.first().future.isFinished()) {
+        const PendingApplet pending = pendingApplets.takeFirst();
+        loaded << pending.future.result();
+        specs << PluginLoader::AppletSpec{pending.pluginName, pending.id, QVariantList()};
+    }
+
+    // the immutability of the containment got restored already, while a
+    // synchronous restore adds the applets before that
+    restoringPendingApplets = true;
+    addLoadedApplets(loaded, specs, QRectF(-1, -1, 0, 0));
+    restoringPendingApplets = false;
+
+    if (!isRestoringApplets()) {
+        // started and uiReady may both be there already, as the event loop kept running
+        checkAppletsUiReady();
+        restoreContentsFinished();
     }
+}
+
+void ContainmentPrivate::restoreDeferredApplet(const PluginLoader::AppletSpec &spec)
+{
+    --deferredApplets;
+
+    // like processPendingApplets, the immutability of the containment got restored already
+    restoringPendingApplets = true;
+    addLoadedApplets(PluginLoader::self()->loadApplets({spec}), {spec}, QRectF(-1, -1, 0, 0));
+    restoringPendingApplets = false;
 
-    q->addApplet(applet, geometryHint);
+    if (!isRestoringApplets()) {
+        checkAppletsUiReady();
+        restoreContentsFinished();
+    }
+}
+
+bool ContainmentPrivate::isRestoringApplets() const
+{
+    return !pendingApplets.isEmpty() || deferredApplets > 0;
+}
+
+QList<Applet *> ContainmentPrivate::addLoadedApplets(QList<Applet *> loaded, const QList<PluginLoader::AppletSpec> &specs, const QRectF &geometryHint)
+{
+    for (int i = 0; i < loaded.count(); ++i) {
+        if (!loaded.at(i)) {
+            qCWarning(LOG_PLASMA) << "Applet" << specs.at(i).name << "could not be loaded.";
+            loaded[i] = new Applet(nullptr, KPluginMetaData(), QVariantList{QVariant(), specs.at(i).appletId});
+            loaded[i]->setLaunchErrorMessage(i18n("Could not find requested component: %1", specs.at(i).name));
+        }
+    }
+
+    addApplets(loaded, geometryHint);
     // mirror behavior of resorecontents: if an applet is not valid, set it immediately to uiReady
-    if (!applet->pluginMetaData().isValid()) {
-        applet->updateConstraints(Applet::UiReadyConstraint);
+    for (Applet *applet : std::as_const(loaded)) {
+        if (!applet->pluginMetaData().isValid()) {
+            applet->updateConstraints(Applet::UiReadyConstraint);
+        }
     }
-    return applet;
+    return loaded;
 }
 
-void ContainmentPrivate::appletDeleted(Plasma::Applet *applet)
+void ContainmentPrivate::restoreContentsFinished()
+{
+    // if there are no applets, none of them is "loading"
+    if (applets.isEmpty()) {
+        appletsUiReady = true;
+    }
+    for (Applet *applet : std::as_const(applets)) {
+        if (!applet->pluginMetaData().isValid()) {
+            applet->updateConstraints(Applet::UiReadyConstraint);
+        }
+    }
+}
+
+void ContainmentPrivate::saveChanges(KConfigGroup &group)
 {
-    Q_EMIT q->appletAboutToBeRemoved(applet);
-    applets.removeAll(applet);
+    if (q->Applet::d->configDirty) {
+        savingChanges = true;
+        q->save(group);
+        savingChanges = false;
+        // the Configuration group is written only once started
+        q->Applet::d->configDirty = !q->Applet::d->started;
+        return;
+    }
+
+    KConfigGroup appletsGroup(&group, QStringLiteral("Applets"));
+    for (Applet *applet : std::as_const(applets)) {
+        if (applet->d->configDirty) {
+            KConfigGroup appletConfig(&appletsGroup, QString::number(applet->id()));
+            applet->save(appletConfig);
+            applet->d->configDirty = !applet->d->started;
+        }
+    }
+}
 
-    Q_EMIT q->appletRemoved(applet);
+void ContainmentPrivate::appletDeleted(Plasma::Applet *applet)
+{
+    // already taken out if it got removed together with others by Containment::removeApplets
+    if (!removeApplets({applet})) {
+        return;
+    }
     Q_EMIT q->appletsChanged();
     Q_EMIT q->configNeedsSaving();
 }
 
+void ContainmentPrivate::addApplets(const QList<Applet *> &newApplets, const QRectF &geometryHint)
+{
+    QList<Applet *> added;
+    added.reserve(newApplets.count());
+    applets.reserve(applets.count() + newApplets.count());
+
+    for (Applet *applet : newApplets) {
+        if (!applet) {
+#ifndef NDEBUG
+            // qCDebug(LOG_PLASMA) << "adding null applet!?!";
+#endif
+            continue;
+        }
+
+        if (q->immutability() != Types::Mutable && !restoringPendingApplets && !applet->property("org.kde.plasma:force-create").toBool()) {
+            continue;
+        }
+
+        Containment *currentContainment = applet->containment();
+
+        if (currentContainment == q && applets.contains(applet)) {
+            // already have this applet
+            continue;
+        }
+
+        if (currentContainment && currentContainment != q) {
+            currentContainment->d->removeApplets({applet});
+            Q_EMIT currentContainment->appletsChanged();
+
+            QObject::disconnect(applet, nullptr, currentContainment, nullptr);
+            QObject::connect(currentContainment, nullptr, applet, nullptr);
+            KConfigGroup oldConfig = applet->config();
+            applet->setParent(q);
+
+            // now move the old config to the new location
+            // FIXME: this doesn't seem to get the actual main config group containing plugin=, etc
+            KConfigGroup c = q->config().group(QStringLiteral("Applets")).group(QString::number(applet->id()));
+            oldConfig.reparent(&c);
+            applet->d->resetConfigurationObject();
+
+            QObject::disconnect(applet, &Applet::activated, currentContainment, &Applet::activated);
+            // change the group to its configloader, if any
+            // FIXME: this is very, very brutal
+            if (applet->configScheme()) {
+                const QString oldGroupPrefix = QStringLiteral("Containments") + QString::number(currentContainment->id()) + QStringLiteral("Applets");
+                const QString newGroupPrefix = QStringLiteral("Containments") + QString::number(q->id()) + QStringLiteral("Applets");
+
+                applet->configScheme()->setCurrentGroup(applet->configScheme()->currentGroup().replace(0, oldGroupPrefix.length(), newGroupPrefix));
+
+                const auto items = applet->configScheme()->items();
+                for (KConfigSkeletonItem *item : items) {
+                    item->setGroup(item->group().replace(0, oldGroupPrefix.length(), newGroupPrefix));
+                }
+            }
+        } else {
+            applet->setParent(q);
+        }
+
+        // make sure the applets are sorted by id: as they mostly come in
+        // ascending order, this is usually an append
+        Q_EMIT q->appletAboutToBeAdded(applet, geometryHint);
+        auto position = std::lower_bound(applets.begin(), applets.end(), applet, [](Plasma::Applet *a1, Plasma::Applet *a2) {
+            return a1->id() < a2->id();
+        });
+        applets.insert(position, applet);
+        added << applet;
+
+        if (!uiReady || restoringPendingApplets) {
+            loadingApplets << applet;
+        }
+
+        QObject::connect(applet, &Applet::configNeedsSaving, q, &Applet::configNeedsSaving);
+        QObject::connect(applet, SIGNAL(appletDeleted(Plasma::Applet *)), q, SLOT(appletDeleted(Plasma::Applet *)));
+        QObject::connect(applet, &Applet::statusChanged, q, [this, applet](Types::ItemStatus status) {
+            appletStatusChanged(applet, status);
+        });
+        trackAppletStatus(applet);
+        QObject::connect(applet, &Applet::activated, q, &Applet::activated);
+        QObject::connect(q, &Containment::containmentDisplayHintsChanged, applet, &Applet::containmentDisplayHintsChanged);
+
+        Applet::Constraints constraints = Applet::AllConstraints;
+        if (!currentContainment) {
+            const bool isNew = applet->d->mainConfigGroup()->entryMap().isEmpty();
+
+            if (!isNew) {
+                applet->restore(*applet->d->mainConfigGroup());
+                applet->d->restoredAt = Tracer::now();
+            }
+
+            applet->init();
+            applet->d->initializedAt = Tracer::now();
+
+            if (isNew) {
+                applet->save(*applet->d->mainConfigGroup());
+                Q_EMIT q->configNeedsSaving();
+            }
+            // FIXME: an on-appear animation would be nice to have again
+
+            constraints |= Applet::StartupCompletedConstraint;
+        }
+
+        applet->updateConstraints(constraints);
+        applet->flushPendingConstraintsEvents();
+
+        Q_EMIT q->appletAdded(applet, geometryHint);
+        Q_EMIT applet->containmentChanged(q);
+
+        applet->d->scheduleModificationNotification();
+    }
+
+    if (added.isEmpty()) {
+        return;
+    }
+
+    // where the added applets ended up, in as few runs as possible
+    const QSet<Applet *> addedSet(added.cbegin(), added.cend());
+    int first = -1;
+    for (int i = 0; i <= applets.count(); ++i) {
+        const bool isAdded = i < applets.count() && addedSet.contains(applets.at(i));
+        if (isAdded && first < 0) {
+            first = i;
+        } else if (!isAdded && first >= 0) {
+            Q_EMIT q->appletsInserted(first, i - 1);
+            first = -1;
+        }
+    }
+    Q_EMIT q->appletsChanged();
+}
+
+bool ContainmentPrivate::removeApplets(const QList<Applet *> &removed)
+{
+    // last to first, so that every position is the same before and after
+    // the removals which came earlier
+    QList<int> positions;
+    for (Applet *applet : removed) {
+        const int i = applets.indexOf(applet);
+        if (i >= 0) {
+            positions << i;
+        }
+    }
+    std::sort(positions.begin(), positions.end(), std::greater<int>());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+    for (int i : std::as_const(positions)) {
+        Applet *applet = applets.at(i);
+        Q_EMIT q->appletAboutToBeRemoved(applet);
+        applets.removeAt(i);
+        untrackAppletStatus(applet);
+        Q_EMIT q->appletRemoved(applet);
+        Q_EMIT q->appletsRemoved(i, i);
+    }
+    return !positions.isEmpty();
+}
+
 bool ContainmentPrivate::isPanelContainment() const
 {
     return type == Plasma::Containment::Type::Panel || type == Plasma::Containment::Type::CustomPanel;
@@ -236,7 +565,7 @@ void ContainmentPrivate::setUiReady()
     // if we are the containment and there is still some incomplete applet, we're still incomplete
     if (!uiReady) {
         uiReady = true;
-        if (q->Applet::d->started && (appletsUiReady || applets.isEmpty()) && loadingApplets.isEmpty()) {
+        if (q->Applet::d->started && (appletsUiReady || applets.isEmpty()) && loadingApplets.isEmpty() && !isRestoringApplets()) {
             Q_EMIT q->uiReadyChanged(true);
         }
     }
@@ -245,8 +574,12 @@ void ContainmentPrivate::setUiReady()
 void ContainmentPrivate::appletLoaded(Applet *applet)
 {
     loadingApplets.remove(applet);
+    checkAppletsUiReady();
+}
 
-    if (loadingApplets.isEmpty() && !appletsUiReady) {
+void ContainmentPrivate::checkAppletsUiReady()
+{
+    if (loadingApplets.isEmpty() && !isRestoringApplets() && !appletsUiReady) {
         appletsUiReady = true;
         if (q->Applet::d->started && uiReady) {
             Q_EMIT q->uiReadyChanged(true);
@@ -8,12 +8,17 @@
 #ifndef CONTAINMENT_P_H
 #define CONTAINMENT_P_H
 
+#include <QFuture>
+#include <QHash>
 #include <QSet>
 
+#include <array>
+
 #include "applet.h"
 #include "containmentactions.h"
 #include "corona.h"
 #include "plasma.h"
+#include "pluginloader.h"
 
 class KJob;
 
@@ -40,6 +45,22 @@ public:
     void triggerShowAddWidgets();
     void checkStatus(Plasma::Types::ItemStatus status);
 
+    /**
+     * Keeps statusCounts up to date with the status of @p applet,
+     * so checkStatus doesn't have to look at every applet
+     */
+    void appletStatusChanged(Applet *applet, Types::ItemStatus status);
+    void trackAppletStatus(Applet *applet);
+    void untrackAppletStatus(Applet *applet);
+    /**
+     * @return the highest status of the applets, HiddenStatus being the lowest
+     */
+    Types::ItemStatus highestAppletStatus() const;
+    /**
+     * For debugging: one of the applets with the status the containment has, if any
+     */
+    const Applet *statusDictatingApplet() const;
+
     /**
      * Called when constraints have been updated on this containment to provide
      * constraint services common to all containments. Containments should still
@@ -49,10 +70,60 @@ public:
 
     bool isPanelContainment() const;
     void appletDeleted(Applet *);
+
+    /**
+     * Adds @p applets, as Containment::addApplet does for a single one, but
+     * notifies about the change of the applets list only once
+     */
+    void addApplets(const QList<Applet *> &applets, const QRectF &geometryHint);
+
+    /**
+     * Takes @p applets out of the list, notifying about each of them
+     * but not with appletsChanged, which is up to the caller
+     * @return true if any of them was there
+     */
+    bool removeApplets(const QList<Applet *> &applets);
     void configChanged();
 
     Applet *createApplet(const QString &name, const QVariantList &args = QVariantList(), uint id = 0, const QRectF &geometryHint = QRectF(-1, -1, 0, 0));
 
+    /**
+     * Batch version of createApplet, loading all the applets with PluginLoader::loadApplets
+     * and adding them in the order of @p specs
+     */
+    void createApplets(const QList<PluginLoader::AppletSpec> &specs);
+
+    /**
+     * Loads the applet with PluginLoader::loadAppletAsync, used when restoring
+     * contents: applets get added in the order this was called, as soon as
+     * they and all the ones requested before them are loaded
+     */
+    void createAppletAsync(const QString &name, uint id);
+    void processPendingApplets();
+    /**
+     * Adds the applets the PluginLoader gave for @p specs in one batch,
+     * replacing the ones which could not be loaded with an applet telling so
+     * @return the applets added
+     */
+    QList<Applet *> addLoadedApplets(QList<Applet *> loaded, const QList<PluginLoader::AppletSpec> &specs, const QRectF &geometryHint);
+    void restoreContentsFinished();
+
+    /**
+     * Restores an applet restoreContents left to CoronaPrivate::scheduleDeferredApplet
+     */
+    void restoreDeferredApplet(const PluginLoader::AppletSpec &spec);
+    /**
+     * @return true while restoreContents didn't add all of the applets yet
+     */
+    bool isRestoringApplets() const;
+
+    /**
+     * Saves only what changed since the last call in @p group, which has to
+     * be the main config group of the containment: the containment itself
+     * if it asked to be saved, and its applets that did
+     */
+    void saveChanges(KConfigGroup &group);
+
     /**
      * FIXME: this should completely go from here
      * @return the config group that containmentactions plugins go in
@@ -68,6 +139,7 @@ public:
     void setUiReady();
     void setStarted();
     void appletLoaded(Applet *applet);
+    void checkAppletsUiReady();
 
     Containment *q;
     Types::FormFactor formFactor;
@@ -78,6 +150,9 @@ public:
     QList<Applet *> applets;
     // Applets still considered not ready
     QSet<Applet *> loadingApplets;
+    // the status of every applet as last seen, and how many applets have each status
+    QHash<const Applet *, Types::ItemStatus> appletStatuses;
+    std::array<int, Types::HiddenStatus + 1> statusCounts = {};
     QString wallpaperPlugin;
     QObject *wallpaperGraphicsObject = nullptr;
     QHash<QString, ContainmentActions *> localActionPlugins;
@@ -86,6 +161,20 @@ public:
     Containment::Type type;
     bool uiReady : 1;
     bool appletsUiReady : 1;
+    // restored applets are added regardless of immutability
+    bool restoringPendingApplets : 1;
+    // Containment::saveContents skips the applets that did not change
+    bool savingChanges : 1;
+
+    struct PendingApplet {
+        QFuture<Applet *> future;
+        QString pluginName;
+        uint id;
+    };
+    // applets being loaded by createAppletAsync, in restore order
+    QList<PendingApplet> pendingApplets;
+    // applets restoreContents left for the Corona to restore later
+    int deferredApplets = 0;
 
     static const char defaultWallpaperPlugin[];
 };
@@ -7,13 +7,23 @@
 #ifndef PLASMA_CORONA_P_H
 #define PLASMA_CORONA_P_H
 
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QPointer>
+#include <QThreadPool>
 #include <QTimer>
 
 #include <KPackage/Package>
 
+#include "pluginloader.h"
+#include "private/layoutsnapshot_p.h"
+
+#include <functional>
+
 namespace Plasma
 {
 class Containment;
+class LoadingTimesModel;
 
 class CoronaPrivate
 {
@@ -27,10 +37,40 @@ public:
     void updateContainmentImmutability();
     void containmentDestroyed(QObject *obj);
     void syncConfig();
+    void writeConfigSnapshot();
+    void configSnapshotWritten(bool written, qint64 bytes);
+    void recordConfigSync(qint64 latency, qint64 bytes);
+    QString configFilePath() const;
     void notifyContainmentsReady();
     void containmentReady(bool ready);
     Containment *addContainment(const QString &name, const QVariantList &args, uint id, int lastScreen, bool delayedInit = false);
+    void addContainmentAsync(const QString &name, uint id);
+    void processPendingContainments();
+    // loads right away whatever asynchronous containment did not finish loading yet
+    void finishPendingContainments();
+    QString containmentPluginName(const QString &name) const;
+    Containment *setupContainment(Applet *applet, const QString &pluginName, uint id, int lastScreen, bool delayedInit);
     QList<Plasma::Containment *> importLayout(const KConfigGroup &conf, bool mergeConfig);
+    void indexContainment(Containment *containment);
+    void unindexContainment(Containment *containment);
+    void addContainmentPlaceholder(const KConfigGroup &containmentConfig, uint id);
+    void materializeContainments(const std::function<bool(const QString &activity, int lastScreen)> &filter);
+    void hibernateContainments();
+    void prefetchLayoutPlugins(const KConfigGroup &conf) const;
+    bool takeSnapshotApplets(Containment *containment, const KConfigGroup &group, QList<LayoutSnapshot::Applet> *applets);
+    /**
+     * Queues @p applet for flushing its pending constraints together with
+     * all the others once the event loop runs again
+     */
+    void scheduleConstraintsFlush(Applet *applet);
+    void flushPendingConstraints();
+    /**
+     * Queues an applet restoreContents of @p containment left for later: the
+     * queue gets restored one applet per event loop pass, highest @p priority
+     * first, then the ones of panels on screen, then by containment and id
+     */
+    void scheduleDeferredApplet(Containment *containment, const PluginLoader::AppletSpec &spec, int priority, bool onPanel);
+    void restoreDeferredApplet();
 
     Corona *q;
     KPackage::Package package;
@@ -40,10 +80,90 @@ public:
     KSharedConfigPtr config;
     QTimer *configSyncTimer;
     QList<Containment *> containments;
+
+    // what each containment is currently filed under in the lookup indexes below,
+    // so that it can be taken out of them even when it's already being destroyed
+    struct ContainmentIndexEntry {
+        int lastScreen = -1;
+        QString activity;
+        int location = Types::Floating;
+    };
+    QHash<Containment *, ContainmentIndexEntry> containmentIndexEntries;
+    // these are sorted by id, like containments
+    QHash<int, QList<Containment *>> containmentsByLastScreen;
+    QHash<QString, QList<Containment *>> containmentsByActivity;
+    // screen() is virtual and may change without screenChanged being emitted, so only the
+    // location is indexed: freeEdges asks the few containments on the edges for their screen
+    QHash<int, QList<Containment *>> containmentsByLocation;
     // It's a map to have values() as a stable list
     QMap<QString, QAction *> actions;
     int containmentsStarting;
     bool editMode = false;
+    bool asynchronousLoading = false;
+    bool asynchronousConfigSync = false;
+    // a snapshot is being written by configWriter, and whether another sync got requested meanwhile
+    bool configWriteInFlight = false;
+    bool configSyncPending = false;
+    // exportLayout holds the syncs back while tearing down containments, and writes once when done
+    bool configSyncSuspended = false;
+    bool configSyncDeferred = false;
+    QThreadPool configWriter;
+    QElapsedTimer configWriteTimer;
+
+    Corona::ConfigSyncPolicy configSyncPolicy;
+    // started by the first sync request since the last sync
+    QElapsedTimer pendingConfigSync;
+    Corona::ConfigSyncStatistics configSyncStatistics;
+    // when the syncs of the last minute happened, on the uptime clock
+    QList<qint64> recentConfigSyncs;
+    QElapsedTimer uptime;
+    // set while importLayout is queueing the containments to load asynchronously
+    bool importingLayout = false;
+    // set while importLayout merges a layout into ours, whose applets are all wanted right away
+    bool mergingLayout = false;
+    // our layout as loadLayout got it, out of a valid snapshot or parsed out of the config,
+    // and the applets it or a merged layout list for the containments importLayout created
+    // and which did not restore yet
+    std::optional<QList<LayoutSnapshot::Containment>> layoutSnapshot;
+    QHash<uint, QList<LayoutSnapshot::Applet>> snapshotApplets;
+
+    // containments of other activities, either not created yet or hibernated
+    struct ContainmentPlaceholder {
+        QString pluginName;
+        QString activity;
+        int lastScreen = -1;
+    };
+    // by id, so they get created in the same order importLayout would
+    QMap<uint, ContainmentPlaceholder> containmentPlaceholders;
+    bool lazyActivityLoading = false;
+    QString currentActivity;
+    QTimer *hibernationTimer;
+    // on the Tracer clock
+    qint64 creationTime;
+    LoadingTimesModel *loadingTimesModel = nullptr;
+
+    // applets with constraints waiting for constraintsTimer, flushed all in one go
+    QList<QPointer<Applet>> pendingConstraintsApplets;
+    QTimer *constraintsTimer;
+    Corona::ConstraintsStatistics constraintsStatistics;
+
+    struct DeferredApplet {
+        QPointer<Containment> containment;
+        uint containmentId;
+        PluginLoader::AppletSpec spec;
+        int priority;
+        bool onPanel;
+    };
+    QList<DeferredApplet> deferredApplets;
+    QTimer *deferredAppletsTimer;
+
+    struct PendingContainment {
+        QFuture<Applet *> future;
+        QString pluginName;
+        uint id;
+    };
+    // containments being loaded by addContainmentAsync, in import order
+    QList<PendingContainment> pendingContainments;
 };
 
 }
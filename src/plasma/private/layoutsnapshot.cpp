@@ -0,0 +1,216 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "private/layoutsnapshot_p.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <algorithm>
+
+#include "debug_p.h"
+
+namespace Plasma
+{
+// "PLLS", bump s_snapshotVersion every time the serialized entries change
+static const quint32 s_snapshotMagic = 0x504c4c53;
+static const quint32 s_snapshotVersion = 3;
+
+// The config is also written by kwriteconfig, KCMs and scripts, and on file systems
+// with coarse mtimes an edit keeping the size passes for the same file: the stamp
+// has a hash of the contents too. Layout configs are small, FNV-1a over the few
+// kilobytes costs nothing next to KConfig parsing the very same file
+struct ConfigFileStamp {
+    qint64 mtime = 0;
+    qint64 size = 0;
+    quint64 hash = 0;
+};
+
+static quint64 hashContents(const QByteArray &contents)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (const char c : contents) {
+        hash ^= quint8(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static std::optional<ConfigFileStamp> stampConfigFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    const QFileInfo info(file);
+    return ConfigFileStamp{info.lastModified().toMSecsSinceEpoch(), info.size(), hashContents(file.readAll())};
+}
+
+static QDataStream &operator<<(QDataStream &stream, const LayoutSnapshot::Applet &applet)
+{
+    stream << applet.group << applet.pluginName << applet.transient;
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, LayoutSnapshot::Applet &applet)
+{
+    stream >> applet.group >> applet.pluginName >> applet.transient;
+    return stream;
+}
+
+static QDataStream &operator<<(QDataStream &stream, const LayoutSnapshot::Containment &containment)
+{
+    stream << containment.group << containment.pluginName << containment.activity << containment.lastScreen << containment.immutability
+           << containment.transient << containment.applets;
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, LayoutSnapshot::Containment &containment)
+{
+    stream >> containment.group >> containment.pluginName >> containment.activity >> containment.lastScreen >> containment.immutability
+        >> containment.transient >> containment.applets;
+    return stream;
+}
+
+QString LayoutSnapshot::filePath(const QString &configFilePath)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma/") + QFileInfo(configFilePath).fileName()
+        + QStringLiteral(".layout");
+}
+
+QList<LayoutSnapshot::Containment> LayoutSnapshot::read(const KConfigGroup &layout, bool withApplets)
+{
+    const KConfigGroup containmentsGroup(&layout, QStringLiteral("Containments"));
+    QStringList groups = containmentsGroup.groupList();
+    std::sort(groups.begin(), groups.end());
+
+    QList<Containment> containments;
+    containments.reserve(groups.count());
+    for (const QString &group : std::as_const(groups)) {
+        if (std::optional<Containment> containment = readContainment(KConfigGroup(&containmentsGroup, group), withApplets)) {
+            containments << *containment;
+        }
+    }
+    return containments;
+}
+
+std::optional<LayoutSnapshot::Containment> LayoutSnapshot::readContainment(const KConfigGroup &containmentConfig, bool withApplets)
+{
+    if (containmentConfig.entryMap().isEmpty()) {
+        return std::nullopt;
+    }
+
+    Containment containment;
+    containment.group = containmentConfig.name();
+    containment.pluginName = containmentConfig.readEntry("plugin", QString());
+    containment.activity = containmentConfig.readEntry("activityId", QString());
+    containment.lastScreen = containmentConfig.readEntry("lastScreen", -1);
+    containment.immutability = containmentConfig.readEntry("immutability", 0);
+    containment.transient = containmentConfig.readEntry(QStringLiteral("transient"), false);
+    if (withApplets) {
+        containment.applets = readApplets(KConfigGroup(&containmentConfig, QStringLiteral("Applets")));
+    }
+    return containment;
+}
+
+QList<LayoutSnapshot::Applet> LayoutSnapshot::readApplets(const KConfigGroup &applets)
+{
+    // ordered by id
+    QStringList groups = applets.groupList();
+    std::sort(groups.begin(), groups.end());
+
+    // then in order of geometry to ensure that applets are added
+    // from left to right or top to bottom for a panel containment
+    QList<QPair<int, Applet>> ordered;
+    ordered.reserve(groups.count());
+    for (const QString &group : std::as_const(groups)) {
+        const KConfigGroup appletConfig(&applets, group);
+        Applet applet;
+        applet.group = group;
+        applet.pluginName = appletConfig.readEntry("plugin", QString());
+        applet.transient = appletConfig.readEntry(QStringLiteral("transient"), false);
+        ordered << qMakePair(appletConfig.readEntry("id", 0), applet);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const QPair<int, Applet> &a1, const QPair<int, Applet> &a2) {
+        return a1.first < a2.first;
+    });
+
+    QList<Applet> list;
+    list.reserve(ordered.count());
+    for (const auto &[position, applet] : std::as_const(ordered)) {
+        list << applet;
+    }
+    return list;
+}
+
+std::optional<QList<LayoutSnapshot::Containment>> LayoutSnapshot::load(const QString &configFilePath)
+{
+    QFile file(filePath(configFilePath));
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return std::nullopt;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_5);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    ConfigFileStamp snapshotStamp;
+    stream >> magic >> version;
+    if (magic != s_snapshotMagic || version != s_snapshotVersion) {
+        return std::nullopt;
+    }
+    stream >> snapshotStamp.mtime >> snapshotStamp.size >> snapshotStamp.hash;
+    const std::optional<ConfigFileStamp> configStamp = stampConfigFile(configFilePath);
+    if (!configStamp || configStamp->mtime != snapshotStamp.mtime || configStamp->size != snapshotStamp.size || configStamp->hash != snapshotStamp.hash) {
+        return std::nullopt;
+    }
+
+    QList<Containment> containments;
+    stream >> containments;
+
+    if (stream.status() != QDataStream::Ok) {
+        qCDebug(LOG_PLASMA) << "Discarding corrupted layout snapshot" << file.fileName();
+        return std::nullopt;
+    }
+    return containments;
+}
+
+void LayoutSnapshot::save(KConfig *config, const QString &configFilePath)
+{
+    const std::optional<ConfigFileStamp> stamp = stampConfigFile(configFilePath);
+    if (!stamp) {
+        return;
+    }
+    const QList<Containment> containments = read(KConfigGroup(config, QString()), true);
+
+    const QString path = filePath(configFilePath);
+    QDir().mkpath(QFileInfo(path).path());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(LOG_PLASMA) << "Could not write the layout snapshot to" << path << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_5);
+    stream << s_snapshotMagic << s_snapshotVersion << stamp->mtime << stamp->size << stamp->hash << containments;
+
+    if (!file.commit()) {
+        qCDebug(LOG_PLASMA) << "Could not write the layout snapshot to" << path << file.errorString();
+    }
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef PLASMA_LAYOUTSNAPSHOT_P_H
+#define PLASMA_LAYOUTSNAPSHOT_P_H
+
+#include <QList>
+#include <QString>
+
+#include <optional>
+
+class KConfig;
+class KConfigGroup;
+
+namespace Plasma
+{
+/**
+ * @internal
+ *
+ * Binary snapshot of the containments and applets in a layout config file.
+ *
+ * Restoring a layout walks the group lists of the config, sorts them and
+ * reads a few entries of every group just to know what to create and in
+ * which order. The snapshot keeps exactly that, already in the order
+ * CoronaPrivate::importLayout and Containment::restoreContents create things,
+ * and is written to the user cache directory after each sync of the config
+ * which changed something. KConfig still parses the whole file, the applets
+ * read their config out of it anyways.
+ *
+ * The config file stays the only source of truth: the snapshot is only used
+ * as long as the mtime, the size and a hash of the contents of the config file
+ * it was taken from match, everything is read from the config otherwise.
+ */
+class LayoutSnapshot
+{
+public:
+    struct Applet {
+        QString group;
+        QString pluginName;
+        bool transient = false;
+    };
+
+    struct Containment {
+        QString group;
+        QString pluginName;
+        QString activity;
+        int lastScreen = -1;
+        int immutability = 0;
+        bool transient = false;
+        QList<Applet> applets;
+    };
+
+    /**
+     * @return the containments in @p layout, the root group of a layout config,
+     *         in the order they get created. Empty groups are skipped. The applets
+     *         are only listed if @p withApplets is true
+     */
+    static QList<Containment> read(const KConfigGroup &layout, bool withApplets);
+
+    /**
+     * @return the containment in @p containment, a group of the Containments group
+     *         of a layout config, nothing if the group is empty. The applets are only
+     *         listed if @p withApplets is true
+     */
+    static std::optional<Containment> readContainment(const KConfigGroup &containment, bool withApplets);
+
+    /**
+     * @return the applets in the Applets group of a containment, in the order they get created
+     */
+    static QList<Applet> readApplets(const KConfigGroup &applets);
+
+    /**
+     * @return the snapshot of the config file at @p configFilePath,
+     *         if there is one and it matches the contents of the file
+     */
+    static std::optional<QList<Containment>> load(const QString &configFilePath);
+
+    /**
+     * Takes a snapshot of @p config, which has just been written to @p configFilePath
+     */
+    static void save(KConfig *config, const QString &configFilePath);
+
+    /**
+     * @return where the snapshot of the config file at @p configFilePath is stored
+     */
+    static QString filePath(const QString &configFilePath);
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "private/loadingtimesmodel_p.h"
+
+namespace Plasma
+{
+LoadingTimesModel::LoadingTimesModel(Corona *corona)
+    : QAbstractListModel(corona)
+    , m_corona(corona)
+{
+    connect(corona, &Corona::startupCompleted, this, &LoadingTimesModel::refresh);
+    refresh();
+}
+
+int LoadingTimesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_times.count();
+}
+
+QVariant LoadingTimesModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return QVariant();
+    }
+
+    const Corona::LoadingTimes &times = m_times.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case PluginNameRole:
+        return times.pluginName;
+    case IdRole:
+        return times.id;
+    case ContainmentIdRole:
+        return times.containmentId;
+    case IsContainmentRole:
+        return times.isContainment;
+    case CreatedRole:
+        return times.created;
+    case InitializedRole:
+        return times.initialized;
+    case RestoredRole:
+        return times.restored;
+    case QmlLoadedRole:
+        return times.qmlLoaded;
+    case UiReadyConstraintRole:
+        return times.uiReadyConstraint;
+    case UiReadyRole:
+        return times.uiReady;
+    case DurationRole:
+        return times.duration;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> LoadingTimesModel::roleNames() const
+{
+    return {
+        {IdRole, QByteArrayLiteral("id")},
+        {ContainmentIdRole, QByteArrayLiteral("containmentId")},
+        {PluginNameRole, QByteArrayLiteral("pluginName")},
+        {IsContainmentRole, QByteArrayLiteral("isContainment")},
+        {CreatedRole, QByteArrayLiteral("created")},
+        {InitializedRole, QByteArrayLiteral("initialized")},
+        {RestoredRole, QByteArrayLiteral("restored")},
+        {QmlLoadedRole, QByteArrayLiteral("qmlLoaded")},
+        {UiReadyConstraintRole, QByteArrayLiteral("uiReadyConstraint")},
+        {UiReadyRole, QByteArrayLiteral("uiReady")},
+        {DurationRole, QByteArrayLiteral("duration")},
+    };
+}
+
+void LoadingTimesModel::refresh()
+{
+    beginResetModel();
+    m_times = m_corona->loadingTimes();
+    endResetModel();
+}
+
+}
+
+#include "moc_loadingtimesmodel_p.cpp"
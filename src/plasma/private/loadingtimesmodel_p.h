@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef PLASMA_LOADINGTIMESMODEL_P_H
+#define PLASMA_LOADINGTIMESMODEL_P_H
+
+#include <QAbstractListModel>
+
+#include "plasma/corona.h"
+
+namespace Plasma
+{
+/**
+ * @internal
+ *
+ * Corona::loadingTimes() as a model, slowest first: filled once the
+ * startup completes and every time refresh() gets called.
+ */
+class LoadingTimesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        ContainmentIdRole,
+        PluginNameRole,
+        IsContainmentRole,
+        CreatedRole,
+        InitializedRole,
+        RestoredRole,
+        QmlLoadedRole,
+        UiReadyConstraintRole,
+        UiReadyRole,
+        DurationRole,
+    };
+
+    explicit LoadingTimesModel(Corona *corona);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    Q_INVOKABLE void refresh();
+
+private:
+    Corona *m_corona;
+    QList<Corona::LoadingTimes> m_times;
+};
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "private/packageregistry_p.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <kpackage/packageloader.h>
+
+#include "private/tracer_p.h"
+
+namespace Plasma
+{
+static qint64 lastModified(const QString &path)
+{
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+PackageRegistry *PackageRegistry::self()
+{
+    static PackageRegistry self;
+    return &self;
+}
+
+KPackage::Package PackageRegistry::package(const QString &pluginId, const QString &rootPath)
+{
+    const KPackage::Package package = cachedPackage(pluginId, rootPath);
+    if (package.isValid()) {
+        return package;
+    }
+    return insert(pluginId, rootPath, loadPackage(pluginId, rootPath));
+}
+
+KPackage::Package PackageRegistry::cachedPackage(const QString &pluginId, const QString &rootPath)
+{
+    auto it = m_entries.find(m_pathsByRequest.value(pluginId + QLatin1Char('\n') + rootPath));
+    if (it == m_entries.end()) {
+        return KPackage::Package();
+    }
+    if (lastModified(it.key()) != it->mtime) {
+        m_entries.erase(it);
+        return KPackage::Package();
+    }
+    return it->package;
+}
+
+KPackage::Package PackageRegistry::loadPackage(const QString &pluginId, const QString &rootPath)
+{
+    Tracer::Scope trace("loadPackage", pluginId);
+    KPackage::Package package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Plasma/Applet"));
+    package.setPath(rootPath.isEmpty() ? pluginId : rootPath);
+    return package;
+}
+
+KPackage::Package PackageRegistry::insert(const QString &pluginId, const QString &rootPath, const KPackage::Package &package)
+{
+    // not cached, so that it gets found once installed
+    if (!package.isValid()) {
+        return package;
+    }
+
+    const QString path = QFileInfo(package.path()).canonicalFilePath();
+    const qint64 mtime = lastModified(path);
+    m_pathsByRequest.insert(pluginId + QLatin1Char('\n') + rootPath, path);
+
+    // the same package, asked for the other way or loaded twice
+    auto it = m_entries.find(path);
+    if (it != m_entries.end() && it->mtime == mtime) {
+        return it->package;
+    }
+
+    m_entries.insert(path, Entry{package, mtime});
+    return package;
+}
+
+}
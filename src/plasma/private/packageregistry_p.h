@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef PLASMA_PACKAGEREGISTRY_P_H
+#define PLASMA_PACKAGEREGISTRY_P_H
+
+#include <QHash>
+#include <QString>
+
+#include <KPackage/Package>
+
+namespace Plasma
+{
+/**
+ * @internal
+ *
+ * Process wide registry of the Plasma/Applet packages in use.
+ *
+ * Every applet instance used to resolve its own package, so five task
+ * managers meant five times the same structure setup and file system walk.
+ * Packages handed out here are shared between all the instances of a plugin,
+ * no matter if they got asked for by plugin id or by package directory: the
+ * entries are kept by the directory the package resolved to.
+ *
+ * An entry is resolved again when the mtime of its package directory changes.
+ * Only to be used from the main thread, except for loadPackage().
+ */
+class PackageRegistry
+{
+public:
+    static PackageRegistry *self();
+
+    /**
+     * @return the shared Plasma/Applet package of @p pluginId, loaded out of
+     *         @p rootPath if not empty, or wherever @p pluginId is installed
+     */
+    KPackage::Package package(const QString &pluginId, const QString &rootPath = QString());
+
+    /**
+     * @return what package() would give for the same arguments if it is
+     *         already shared and did not change since, an invalid package otherwise
+     */
+    KPackage::Package cachedPackage(const QString &pluginId, const QString &rootPath = QString());
+
+    /**
+     * Loads a new package like package() does, without sharing it.
+     * Can be called from any thread, to hand the package to insert() afterwards.
+     */
+    static KPackage::Package loadPackage(const QString &pluginId, const QString &rootPath = QString());
+
+    /**
+     * Shares @p package, as returned by loadPackage() for the same arguments
+     * @return the package to use: the one shared already if the same package
+     *         got there first, @p package itself otherwise
+     */
+    KPackage::Package insert(const QString &pluginId, const QString &rootPath, const KPackage::Package &package);
+
+private:
+    struct Entry {
+        KPackage::Package package;
+        qint64 mtime = 0;
+    };
+
+    // canonical package directory -> entry
+    QHash<QString, Entry> m_entries;
+    // pluginId + '\n' + rootPath -> key in m_entries, of what was asked for before
+    QHash<QString, QString> m_pathsByRequest;
+};
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "private/tracer_p.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "debug_p.h"
+
+namespace Plasma
+{
+// ~80 KiB per thread that ever recorded something, plus its details
+static constexpr quint64 s_bufferCapacity = 2048;
+static constexpr qint64 s_instant = -1;
+
+struct TraceEvent {
+    // odd while the event is being written, bumped twice per write
+    std::atomic<quint32> sequence{0};
+    const char *name = nullptr;
+    qint64 begin = 0;
+    qint64 duration = 0;
+    // points into TraceBuffer::details
+    const char *detail = nullptr;
+};
+
+struct TraceBuffer {
+    std::array<TraceEvent, s_bufferCapacity> events;
+    // how many events were ever written, only moved by the owning thread
+    std::atomic<quint64> head{0};
+    quint64 threadId = 0;
+    QString threadName;
+    // every detail recorded by the thread in UTF-8, only ever added to by the owning
+    // thread: the converted data does not move, so events can point to it
+    QHash<QString, QByteArray> details;
+};
+
+struct TraceRegistry {
+    TraceRegistry()
+    {
+        clock.start();
+    }
+
+    QElapsedTimer clock;
+    QMutex mutex;
+    // buffers outlive their threads, so that what they recorded can still be exported
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+};
+Q_GLOBAL_STATIC(TraceRegistry, s_registry)
+
+static TraceBuffer *threadBuffer()
+{
+    // the registry lock is only taken the first time a thread records something
+    thread_local std::shared_ptr<TraceBuffer> buffer = []() {
+        auto buffer = std::make_shared<TraceBuffer>();
+        QThread *thread = QThread::currentThread();
+        buffer->threadId = quint64(quintptr(QThread::currentThreadId()));
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            buffer->threadName = QStringLiteral("main");
+        } else {
+            buffer->threadName = thread->objectName();
+        }
+
+        QMutexLocker locker(&s_registry->mutex);
+        s_registry->buffers.push_back(buffer);
+        return buffer;
+    }();
+    return buffer.get();
+}
+
+static const char *internDetail(TraceBuffer *buffer, const QString &detail)
+{
+    if (detail.isEmpty()) {
+        return nullptr;
+    }
+    auto it = buffer->details.constFind(detail);
+    if (it == buffer->details.cend()) {
+        it = buffer->details.insert(detail, detail.toUtf8());
+    }
+    return it->constData();
+}
+
+static void record(const char *name, qint64 begin, qint64 duration, const QString &detail)
+{
+    TraceBuffer *buffer = threadBuffer();
+    const char *internedDetail = internDetail(buffer, detail);
+    const quint64 head = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent &event = buffer->events[head % s_bufferCapacity];
+
+    // seqlock: a reader seeing the same even sequence before and after copying got a consistent event
+    const quint32 sequence = event.sequence.load(std::memory_order_relaxed);
+    event.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.name = name;
+    event.begin = begin;
+    event.duration = duration;
+    event.detail = internedDetail;
+
+    event.sequence.store(sequence + 2, std::memory_order_release);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+qint64 Tracer::now()
+{
+    return s_registry->clock.nsecsElapsed();
+}
+
+void Tracer::span(const char *name, qint64 begin, const QString &detail)
+{
+    record(name, begin, now() - begin, detail);
+}
+
+void Tracer::instant(const char *name, const QString &detail)
+{
+    record(name, now(), s_instant, detail);
+}
+
+QByteArray Tracer::chromeTrace()
+{
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        QMutexLocker locker(&s_registry->mutex);
+        buffers = s_registry->buffers;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    for (const std::shared_ptr<TraceBuffer> &buffer : buffers) {
+        if (!buffer->threadName.isEmpty()) {
+            traceEvents.append(QJsonObject{
+                {QStringLiteral("name"), QStringLiteral("thread_name")},
+                {QStringLiteral("ph"), QStringLiteral("M")},
+                {QStringLiteral("pid"), pid},
+                {QStringLiteral("tid"), qint64(buffer->threadId)},
+                {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), buffer->threadName}}},
+            });
+        }
+
+        const quint64 head = buffer->head.load(std::memory_order_acquire);
+        const quint64 first = head > s_bufferCapacity ? head - s_bufferCapacity : 0;
+        for (quint64 i = first; i < head; ++i) {
+            const TraceEvent &event = buffer->events[i % s_bufferCapacity];
+            const quint32 sequence = event.sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+            const char *name = event.name;
+            const qint64 begin = event.begin;
+            const qint64 duration = event.duration;
+            const char *detail = event.detail;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // overwritten by its thread while we were copying it
+            if (event.sequence.load(std::memory_order_relaxed) != sequence || !name) {
+                continue;
+            }
+
+            QJsonObject json{
+                {QStringLiteral("name"), QString::fromUtf8(name)},
+                {QStringLiteral("cat"), QStringLiteral("plasma")},
+                {QStringLiteral("pid"), pid},
+                {QStringLiteral("tid"), qint64(buffer->threadId)},
+                // the format wants microseconds
+                {QStringLiteral("ts"), begin / 1000.0},
+            };
+            if (duration == s_instant) {
+                json.insert(QStringLiteral("ph"), QStringLiteral("i"));
+                json.insert(QStringLiteral("s"), QStringLiteral("t"));
+            } else {
+                json.insert(QStringLiteral("ph"), QStringLiteral("X"));
+                json.insert(QStringLiteral("dur"), duration / 1000.0);
+            }
+            if (detail) {
+                json.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("detail"), QString::fromUtf8(detail)}});
+            }
+            traceEvents.append(json);
+        }
+    }
+
+    const QJsonObject trace{
+        {QStringLiteral("traceEvents"), traceEvents},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::exportChromeTrace(const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LOG_PLASMA) << "Could not write the trace to" << fileName << file.errorString();
+        return false;
+    }
+    file.write(chromeTrace());
+    if (!file.commit()) {
+        qCWarning(LOG_PLASMA) << "Could not write the trace to" << fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+static void exportAtQuit()
+{
+    if (!qEnvironmentVariableIsSet("PLASMA_TRACK_STARTUP")) {
+        return;
+    }
+
+    QString fileName = qEnvironmentVariable("PLASMA_TRACK_STARTUP");
+    if (fileName.isEmpty() || fileName == QLatin1String("1")) {
+        fileName = QDir::tempPath() + QStringLiteral("/plasma-trace-") + qEnvironmentVariable("USER") + QStringLiteral(".json");
+    }
+    Tracer::exportChromeTrace(fileName);
+}
+
+static void setupTracer()
+{
+    // start the clock together with the application rather than at the first event
+    Tracer::now();
+    QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, &exportAtQuit);
+}
+Q_COREAPP_STARTUP_FUNCTION(setupTracer)
+
+}
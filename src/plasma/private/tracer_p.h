@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2026 Plasma Developers <plasma-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef PLASMA_TRACER_P_H
+#define PLASMA_TRACER_P_H
+
+#include <QString>
+
+#include "plasma/plasma_export.h"
+
+namespace Plasma
+{
+/**
+ * @internal
+ *
+ * Always on tracer of what happens while Plasma starts: loading plugins and
+ * packages, compiling and creating QML, applets and containments becoming
+ * ready and the startup completing.
+ *
+ * Every thread records into its own fixed size ring buffer, without taking
+ * any lock, so recording costs a couple of timestamps and a lookup: the oldest
+ * events of a thread get overwritten once its buffer is full. Details are
+ * converted to UTF-8 the first time a thread records them and kept from there
+ * on, so they should come out of a small set, like plugin names or paths. What is in the
+ * buffers can be exported at any time in the Chrome trace event format, which
+ * chrome://tracing and https://ui.perfetto.dev open.
+ *
+ * If PLASMA_TRACK_STARTUP is set, the trace gets written at quit to the file
+ * it names, or to plasma-trace-$USER.json in the temporary directory.
+ *
+ * Event names must be string literals: only the pointer is stored.
+ *
+ * Installed as a private header for PlasmaQuick, which traces the QML it
+ * compiles and creates: it is not part of the public API and can change
+ * between any two versions.
+ */
+class PLASMA_EXPORT Tracer
+{
+public:
+    /**
+     * @return the current time on the tracer clock, in nanoseconds
+     */
+    static qint64 now();
+
+    /**
+     * Records a span called @p name going from @p begin, as returned by now(), until now
+     */
+    static void span(const char *name, qint64 begin, const QString &detail = QString());
+
+    /**
+     * Records something called @p name happening now
+     */
+    static void instant(const char *name, const QString &detail = QString());
+
+    /**
+     * @return all the recorded events in the Chrome trace event JSON format
+     */
+    static QByteArray chromeTrace();
+
+    /**
+     * Writes chromeTrace() to @p fileName
+     * @return true on success
+     */
+    static bool exportChromeTrace(const QString &fileName);
+
+    /**
+     * Records a span from its construction until it goes out of scope
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name, const QString &detail = QString())
+            : m_name(name)
+            , m_detail(detail)
+            , m_begin(Tracer::now())
+        {
+        }
+        ~Scope()
+        {
+            Tracer::span(m_name, m_begin, m_detail);
+        }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        const char *m_name;
+        QString m_detail;
+        qint64 m_begin;
+    };
+};
+
+}
+
+#endif
@@ -603,6 +603,7 @@ AppletQuickItem *AppletQuickItem::itemForApplet(Plasma::Applet *applet)
     AppletQuickItemPrivate::s_itemsForApplet[applet] = item;
     qmlObject->setInitializationDelayed(false);
     qmlObject->completeInitialization();
+    applet->markQmlLoaded();
 
     // A normal applet has UI ready as soon as is loaded, a containment, only when also the wallpaper is loaded
     if (!pc || !pc->isContainment()) {
@@ -507,7 +507,7 @@ void ContainmentItem::mimeTypeRetrieved(KIO::Job *job, const QString &mimetype)
 
         qDebug() << "Creating menu for: " << mimetype;
 
-        appletList << Plasma::PluginLoader::self()->listAppletMetaDataForMimeType(mimetype);
+        appletList << Plasma::PluginLoader::self()->listAppletMetaDataForMimeType(mimetype, Plasma::PluginLoader::InheritedMimeTypeMatch);
 
         QList<KPluginMetaData> wallpaperList;
 
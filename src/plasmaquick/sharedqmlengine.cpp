@@ -18,6 +18,8 @@
 
 #include <Plasma/Applet>
 
+#include "plasma/private/tracer_p.h"
+
 #include "debug_p.h"
 
 namespace PlasmaQuick
@@ -104,8 +106,14 @@ void SharedQmlEnginePrivate::execute(const QUrl &source)
     component = new QQmlComponent(m_engine.get(), q);
     QObject::connect(component, &QQmlComponent::statusChanged, q, &SharedQmlEngine::statusChanged, Qt::QueuedConnection);
 
-    component->loadUrl(source);
-    rootObject = component->beginCreate(rootContext);
+    {
+        Plasma::Tracer::Scope trace("compileQml", source.toString());
+        component->loadUrl(source);
+    }
+    {
+        Plasma::Tracer::Scope trace("createQml", source.toString());
+        rootObject = component->beginCreate(rootContext);
+    }
 
     if (delay) {
         executionEndTimer->start(0);
@@ -236,20 +244,27 @@ void SharedQmlEngine::completeInitialization(const QVariantHash &initialProperti
         d->rootObject->setProperty(it.key().toUtf8().data(), it.value());
     }
 
-    d->component->completeCreate();
+    {
+        Plasma::Tracer::Scope trace("completeQml", d->component->url().toString());
+        d->component->completeCreate();
+    }
     Q_EMIT finished();
 }
 
 QObject *SharedQmlEngine::createObjectFromSource(const QUrl &source, QQmlContext *context, const QVariantHash &initialProperties)
 {
     QQmlComponent *component = new QQmlComponent(d->m_engine.get(), this);
-    component->loadUrl(source);
+    {
+        Plasma::Tracer::Scope trace("compileQml", source.toString());
+        component->loadUrl(source);
+    }
 
     return createObjectFromComponent(component, context, initialProperties);
 }
 
 QObject *SharedQmlEngine::createObjectFromComponent(QQmlComponent *component, QQmlContext *context, const QVariantHash &initialProperties)
 {
+    Plasma::Tracer::Scope trace("createQml", component->url().toString());
     QObject *object = component->beginCreate(context ? context : d->rootContext);
 
     for (auto it = initialProperties.constBegin(); it != initialProperties.constEnd(); ++it) {